@@ -0,0 +1,105 @@
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "mem64/allocator.hpp"
+#include "bench_util.hpp"
+#include "fake_handle.hpp"
+
+using namespace Mem64;
+using namespace Mem64Test;
+using namespace Mem64Bench;
+
+using Alloc = GuestAllocator<VecHandle>;
+
+
+/// Largest block the allocator can still place, found by bisection
+static std::uint32_t largest_free(Alloc& alloc)
+{
+    std::uint32_t lo{0}, hi{1u << 24};
+    while(lo < hi)
+    {
+        auto mid{lo + (hi - lo + 1) / 2};
+        auto addr{alloc.allocate_raw(mid, 8)};
+        if(addr == VecHandle::INVALID_OFFSET)
+        {
+            hi = mid - 1;
+        }
+        else
+        {
+            alloc.deallocate_raw(addr, mid, 8);
+            lo = mid;
+        }
+    }
+    return lo;
+}
+
+/// Allocation rate and fragmentation of GuestAllocator, allocation rate of FrameArena
+int main()
+{
+    constexpr std::uint32_t BASE{0x1000}, SIZE{4 << 20};
+    std::vector<std::uint8_t> mem(BASE + SIZE);
+    VecHandle hdl{mem};
+
+    {
+        Alloc alloc{hdl, BASE, SIZE};
+        std::vector<Alloc::AddrType> addrs(1024);
+
+        for(std::uint32_t size : {8u, 64u, 1024u, 4096u})
+        {
+            auto ns{ns_per_op(1000, [&](std::size_t)
+            {
+                for(auto& addr : addrs)
+                    addr = alloc.allocate_raw(size, 8);
+                for(auto addr : addrs)
+                    alloc.deallocate_raw(addr, size, 8);
+            })};
+            std::printf("alloc+free %5u bytes   %8.1f ns\n", size, ns / static_cast<double>(addrs.size()));
+        }
+    }
+
+    {
+        FrameArena<VecHandle> arena{hdl, BASE, SIZE};
+        auto ns{ns_per_op(1000, [&](std::size_t)
+        {
+            for(int i{}; i < 1024; ++i)
+                keep(arena.allocate_raw(48, 8));
+            arena.reset();
+        })};
+        std::printf("arena alloc 48 bytes     %8.1f ns\n", ns / 1024.0);
+    }
+
+    // Random mix of small and large lifetimes, fragmentation after each phase
+    Alloc alloc{hdl, BASE, SIZE};
+    std::mt19937 rng{42};
+    std::vector<std::pair<Alloc::AddrType, std::uint32_t>> live;
+    std::size_t failed{};
+
+    std::printf("%8s %12s %14s %14s\n", "phase", "bytes used", "largest free", "failed allocs");
+    for(int phase{1}; phase <= 5; ++phase)
+    {
+        for(int i{}; i < 20000; ++i)
+        {
+            if(!live.empty() && rng() % 100 < 45)
+            {
+                auto idx{rng() % live.size()};
+                alloc.deallocate_raw(live[idx].first, live[idx].second, 8);
+                live[idx] = live.back();
+                live.pop_back();
+                continue;
+            }
+
+            auto size{static_cast<std::uint32_t>(rng() % 10 < 8 ? 8 + rng() % 256 : 2048 + rng() % 16384)};
+            auto addr{alloc.allocate_raw(size, 8)};
+            if(addr == VecHandle::INVALID_OFFSET)
+                ++failed;
+            else
+                live.emplace_back(addr, size);
+        }
+
+        std::printf("%8d %12u %14u %14zu\n", phase, alloc.bytes_used(), largest_free(alloc), failed);
+    }
+
+    for(auto [addr, size] : live)
+        alloc.deallocate_raw(addr, size, 8);
+    std::printf("%8s %12u %14u\n", "freed", alloc.bytes_used(), largest_free(alloc));
+}
@@ -0,0 +1,73 @@
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include "mem64/mem64.hpp"
+#include "mem64/any_handle.hpp"
+#include "bench_util.hpp"
+#include "fake_handle.hpp"
+
+using namespace Mem64;
+using namespace Mem64Test;
+using namespace Mem64Bench;
+
+
+/// Cost of type erasure against the concrete handles, with and without the line cache
+int main()
+{
+    constexpr std::uint32_t SIZE{1 << 20};
+    constexpr std::uint32_t HOT{0x33B170};
+    std::vector<std::uint8_t> mem(HOT + 0x1000);
+
+    constexpr std::size_t ITERS{2000000};
+
+    // Scalar reads clustered around one struct, the access pattern of a game state poll
+    auto scalars{[&](auto& hdl, std::size_t iters)
+    {
+        return ns_per_op(iters, [&](std::size_t i)
+        {
+            keep(hdl.template read<std::uint32_t>(static_cast<std::uint32_t>(HOT + (i * 4) % 256)));
+        });
+    }};
+
+    auto bulk{[&](auto& hdl)
+    {
+        std::vector<std::uint8_t> buf(4096);
+        auto ns{ns_per_op(ITERS / 64, [&](std::size_t i)
+        {
+            hdl.read_raw(static_cast<std::uint32_t>((i * 4096) % SIZE), buf.data(), 4096);
+            keep(buf[i % 4096]);
+        })};
+        return mb_per_sec(4096, ns);
+    }};
+
+    auto report{[](const char* name, double scalar_ns, double bulk_mb)
+    {
+        std::printf("%-32s %8.2f ns/read", name, scalar_ns);
+        if(bulk_mb > 0.0)
+            std::printf(" %10.1f MB/s bulk", bulk_mb);
+        std::printf("\n");
+    }};
+
+    VecHandle vec{mem};
+    report("VecHandle", scalars(vec, ITERS), bulk(vec));
+
+    DirectVecHandle direct{mem};
+    report("DirectVecHandle", scalars(direct, ITERS), bulk(direct));
+
+    AnyHandle any{VecHandle{mem}};
+    report("AnyHandle(VecHandle)", scalars(any, ITERS), bulk(any));
+
+    any.enable_cache(HOT, 0x1000);
+    report("AnyHandle(VecHandle), cached", scalars(any, ITERS), bulk(any));
+
+    // Backends behind a process boundary are where the cache pays off
+    constexpr std::size_t SLOW_ITERS{ITERS / 100};
+    VecHandle slow{mem, std::chrono::nanoseconds{500}};
+    report("VecHandle, 500 ns/call", scalars(slow, SLOW_ITERS), 0.0);
+
+    AnyHandle any_slow{VecHandle{mem, std::chrono::nanoseconds{500}}};
+    report("AnyHandle, 500 ns/call", scalars(any_slow, SLOW_ITERS), 0.0);
+
+    any_slow.enable_cache(HOT, 0x1000);
+    report("AnyHandle, 500 ns/call, cached", scalars(any_slow, SLOW_ITERS), 0.0);
+}
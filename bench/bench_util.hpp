@@ -0,0 +1,40 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+
+namespace Mem64Bench
+{
+
+/// Volatile sink of keep, a namespace scope object so storing to it counts as a use
+inline volatile std::uint8_t keep_sink{};
+
+/// Keep the compiler from dropping a computed value
+template<typename T>
+void keep(const T& val)
+{
+    keep_sink = *reinterpret_cast<const volatile std::uint8_t*>(&val);
+}
+
+/// Average nanoseconds per call of fn over iters calls
+template<typename TFn>
+double ns_per_op(std::size_t iters, TFn&& fn)
+{
+    auto start{std::chrono::steady_clock::now()};
+    for(std::size_t i{}; i < iters; ++i)
+        fn(i);
+    auto elapsed{std::chrono::steady_clock::now() - start};
+
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) /
+           static_cast<double>(iters);
+}
+
+inline double mb_per_sec(std::size_t bytes, double ns)
+{
+    return ns > 0.0 ? static_cast<double>(bytes) * 1e3 / ns : 0.0;
+}
+
+} // Mem64Bench
@@ -0,0 +1,40 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "mem64/copy.hpp"
+#include "bench_util.hpp"
+#include "fake_handle.hpp"
+
+using namespace Mem64;
+using namespace Mem64Test;
+using namespace Mem64Bench;
+
+
+/// Throughput of copy() between two slow handles by chunk size, with and without pipelining
+///
+/// Usage: copy_bench [latency_ns per handle call, default 2000]
+int main(int argc, char** argv)
+{
+    std::chrono::nanoseconds latency{argc > 1 ? std::atoll(argv[1]) : 2000};
+    constexpr std::size_t SIZE{8 << 20};
+
+    std::vector<std::uint8_t> src_mem(SIZE, 0xA5), dst_mem(SIZE);
+
+    {
+        DirectVecHandle src{src_mem}, dst{dst_mem};
+        auto ns{ns_per_op(8, [&](std::size_t){ copy(src, 0, dst, 0, SIZE); })};
+        std::printf("%-24s %10.1f MB/s\n", "direct memmove", mb_per_sec(SIZE, ns));
+    }
+
+    VecHandle src{src_mem, latency}, dst{dst_mem, latency};
+    std::printf("slow handles, %lld ns per call\n", static_cast<long long>(latency.count()));
+    std::printf("%10s %14s %14s\n", "chunk", "chunked MB/s", "pipelined MB/s");
+
+    for(std::size_t chunk{1024}; chunk <= (1 << 20); chunk *= 4)
+    {
+        auto chunked{ns_per_op(4, [&](std::size_t){ copy(src, 0, dst, 0, SIZE, CopyOptions{chunk, false}); })};
+        auto pipelined{ns_per_op(4, [&](std::size_t){ copy(src, 0, dst, 0, SIZE, CopyOptions{chunk, true}); })};
+        std::printf("%10zu %14.1f %14.1f\n", chunk, mb_per_sec(SIZE, chunked), mb_per_sec(SIZE, pipelined));
+    }
+}
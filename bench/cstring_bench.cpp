@@ -0,0 +1,59 @@
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "mem64/mem64.hpp"
+#include "mem64/cstring.hpp"
+#include "bench_util.hpp"
+#include "fake_handle.hpp"
+
+using namespace Mem64;
+using namespace Mem64Test;
+using namespace Mem64Bench;
+
+
+/// Guest string reads against per character Ref<char> reads, and TextTable translation throughput
+int main()
+{
+    std::vector<std::uint8_t> mem(1 << 16, 'a');
+    for(std::size_t i{31}; i < mem.size(); i += 32)
+        mem[i] = 0;
+
+    VecHandle hdl{mem};
+    std::string buf;
+
+    auto per_char{ns_per_op(100000, [&](std::size_t i)
+    {
+        Ptr<char, VecHandle> ptr{hdl, static_cast<VecHandle::addr_t>(i % 1024 * 32)};
+        buf.clear();
+        for(char c; (c = ptr->read()) != 0; ++ptr)
+            buf.push_back(c);
+        keep(buf.size());
+    })};
+    std::printf("%-28s %8.1f ns/string\n", "Ref<char> per byte", per_char);
+
+    auto chunked{ns_per_op(100000, [&](std::size_t i)
+    {
+        keep(read_cstr(hdl, static_cast<VecHandle::addr_t>(i % 1024 * 32), buf, 64).size());
+    })};
+    std::printf("%-28s %8.1f ns/string\n", "read_cstr", chunked);
+
+    DirectVecHandle direct{mem};
+    auto zero_copy{ns_per_op(100000, [&](std::size_t i)
+    {
+        keep(read_cstr(direct, static_cast<VecHandle::addr_t>(i % 1024 * 32), buf, 64).size());
+    })};
+    std::printf("%-28s %8.1f ns/string\n", "read_cstr, direct access", zero_copy);
+
+    std::array<char, 256> decode;
+    for(std::size_t i{}; i < decode.size(); ++i)
+        decode[i] = static_cast<char>(' ' + i % 95);
+    TextTable table{decode, 0xFF, 0x9E};
+
+    std::string text(1 << 20, 'm');
+    auto decode_ns{ns_per_op(50, [&](std::size_t){ table.decode(text); keep(text[0]); })};
+    auto encode_ns{ns_per_op(50, [&](std::size_t){ table.encode(text); keep(text[0]); })};
+    std::printf("%-28s %8.1f MB/s\n", "TextTable::decode", mb_per_sec(text.size(), decode_ns));
+    std::printf("%-28s %8.1f MB/s\n", "TextTable::encode", mb_per_sec(text.size(), encode_ns));
+}
@@ -0,0 +1,60 @@
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include "mem64/mem64.hpp"
+#include "mem64/lazy.hpp"
+#include "bench_util.hpp"
+#include "fake_handle.hpp"
+
+using namespace Mem64;
+using namespace Mem64Test;
+using namespace Mem64Bench;
+
+
+struct Mario
+{
+    std::uint32_t action;
+    std::int16_t timer;
+    std::int16_t health;
+    float vel[3];
+    std::uint16_t coins;
+};
+
+/// Game state condition over four fields, evaluated eagerly and as one fused lazy expression
+int main()
+{
+    std::vector<std::uint8_t> mem(0x10000);
+
+    for(auto latency : {std::chrono::nanoseconds{}, std::chrono::nanoseconds{2000}})
+    {
+        VecHandle hdl{mem, latency};
+        Ref<Mario, VecHandle> mario{hdl, 0x1000};
+        auto action{mario.field(&Mario::action)};
+        auto timer{mario.field(&Mario::timer)};
+        auto health{mario.field(&Mario::health)};
+        auto coins{mario.field(&Mario::coins)};
+        action = 0x0C400201u;
+        health = std::int16_t{0x880};
+
+        auto iters{latency.count() ? std::size_t{20000} : std::size_t{2000000}};
+
+        auto eager{ns_per_op(iters, [&](std::size_t)
+        {
+            keep(action.read() == 0x0C400201u && timer.read() < 30 && health.read() > 0x100 && coins.read() < 50);
+        })};
+
+        auto fused{ns_per_op(iters, [&](std::size_t)
+        {
+            keep(static_cast<bool>(lazy(action) == 0x0C400201u && lazy(timer) < 30 && lazy(health) > 0x100 &&
+                                   lazy(coins) < 50));
+        })};
+
+        hdl.reads.reset();
+        keep(static_cast<bool>(lazy(action) == 0x0C400201u && lazy(timer) < 30 && lazy(health) > 0x100 &&
+                               lazy(coins) < 50));
+        std::size_t lazy_reads{hdl.reads};
+
+        std::printf("latency %5lld ns: eager %9.1f ns (4 reads), lazy %9.1f ns (%zu read)\n",
+                    static_cast<long long>(latency.count()), eager, fused, lazy_reads);
+    }
+}
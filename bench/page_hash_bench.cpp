@@ -0,0 +1,56 @@
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "mem64/page_hash.hpp"
+#include "bench_util.hpp"
+#include "fake_handle.hpp"
+
+using namespace Mem64;
+using namespace Mem64Test;
+using namespace Mem64Bench;
+
+
+/// Per frame cost of PageHashIndex::update on 8 MB of RDRAM against reading and comparing everything
+int main()
+{
+    constexpr std::size_t SIZE{8 << 20};
+    std::vector<std::uint8_t> mem(SIZE, 0x11), prev(SIZE), cur(SIZE);
+
+    {
+        VecHandle hdl{mem};
+        auto ns{ns_per_op(20, [&](std::size_t)
+        {
+            hdl.read_raw(0, cur.data(), SIZE);
+            keep(std::memcmp(cur.data(), prev.data(), SIZE));
+        })};
+        std::printf("%-28s %8.1f us/frame\n", "read_raw + memcmp", ns / 1e3);
+    }
+
+    for(unsigned threads : {1u, 2u, 4u})
+    {
+        VecHandle hdl{mem};
+        PageHashIndex<VecHandle> index{hdl, 0, SIZE, threads};
+        index.update();
+
+        auto ns{ns_per_op(20, [&](std::size_t i)
+        {
+            mem[(i * 40961) % SIZE] ^= 1;
+            keep(index.update()[0]);
+        })};
+        std::printf("update, copy, %u thread(s)     %8.1f us/frame\n", threads, ns / 1e3);
+    }
+
+    for(unsigned threads : {1u, 2u, 4u})
+    {
+        DirectVecHandle hdl{mem};
+        PageHashIndex<DirectVecHandle> index{hdl, 0, SIZE, threads};
+        index.update();
+
+        auto ns{ns_per_op(20, [&](std::size_t i)
+        {
+            mem[(i * 40961) % SIZE] ^= 1;
+            keep(index.update()[0]);
+        })};
+        std::printf("update, direct, %u thread(s)   %8.1f us/frame\n", threads, ns / 1e3);
+    }
+}
@@ -0,0 +1,61 @@
+#include <cstdio>
+#include <type_traits>
+#include <vector>
+#include "mem64/mem64.hpp"
+#include "bench_util.hpp"
+#include "fake_handle.hpp"
+
+using namespace Mem64;
+using namespace Mem64Test;
+using namespace Mem64Bench;
+
+
+/// Summing and updating guest arrays through pins against per element Ref access
+int main()
+{
+    std::vector<std::uint8_t> mem(1 << 20);
+
+    auto run{[&](const char* name, auto& hdl)
+    {
+        using HandleType = std::remove_reference_t<decltype(hdl)>;
+
+        for(std::uint32_t count : {64u, 4096u, 65536u})
+        {
+            Ptr<std::uint32_t, HandleType> ptr{hdl, 0x1000};
+            auto iters{(std::size_t{1} << 24) / count};
+
+            auto per_elem{ns_per_op(iters, [&](std::size_t)
+            {
+                std::uint32_t sum{};
+                for(std::uint32_t i{}; i < count; ++i)
+                    sum += ptr[i].read();
+                keep(sum);
+            })};
+
+            auto pinned{ns_per_op(iters, [&](std::size_t)
+            {
+                std::uint32_t sum{};
+                for(auto v : ptr.span(count))
+                    sum += v;
+                keep(sum);
+            })};
+
+            auto update{ns_per_op(iters, [&](std::size_t i)
+            {
+                auto edit{ptr.span_mut(count)};
+                edit[i % count] += 1;
+                edit.flush();
+            })};
+
+            std::printf("%-16s %6u elems: per Ref %8.2f MB/s, span %9.1f MB/s, update one elem %9.1f ns\n", name,
+                        count, mb_per_sec(count * 4, per_elem), mb_per_sec(count * 4, pinned),
+                        update);
+        }
+    }};
+
+    VecHandle vec{mem};
+    run("VecHandle", vec);
+
+    DirectVecHandle direct{mem};
+    run("DirectVecHandle", direct);
+}
@@ -0,0 +1,73 @@
+#include <array>
+#include <cstdio>
+#include <vector>
+#include "mem64/mem64.hpp"
+#include "bench_util.hpp"
+#include "fake_handle.hpp"
+
+using namespace Mem64;
+using namespace Mem64Test;
+using namespace Mem64Bench;
+
+
+/// Handle carrying a line cache and stats, the kind of state Refs used to copy on every step
+struct HeavyHandle : VecHandle
+{
+    using VecHandle::VecHandle;
+
+    std::array<std::uint8_t, 4096> cache{};
+};
+
+struct Player
+{
+    std::uint32_t action;
+    float pos[3];
+    std::int16_t health;
+};
+
+template<typename TRef>
+__attribute__((noinline)) std::uint32_t read_action(TRef player)
+{
+    return player.field(&Player::action).read();
+}
+
+/// Cost of deriving and passing Refs, against copying the handle as Refs did before they pointed to it
+int main()
+{
+    std::vector<std::uint8_t> mem(0x10000);
+    HeavyHandle hdl{mem};
+    Ptr<Player, HeavyHandle> players{hdl, 0x1000};
+
+    constexpr std::size_t ITERS{2000000};
+
+    auto handle_copy{ns_per_op(ITERS, [&](std::size_t i)
+    {
+        HeavyHandle copy{hdl};
+        keep(copy.cache[i % 64]);
+    })};
+
+    auto derive{ns_per_op(ITERS, [&](std::size_t i)
+    {
+        keep(players[i % 256].field(&Player::pos)[i % 3].offset());
+    })};
+
+    auto pass{ns_per_op(ITERS, [&](std::size_t i)
+    {
+        keep(read_action(players[i % 256]));
+    })};
+
+    auto walk{ns_per_op(ITERS / 256, [&](std::size_t)
+    {
+        std::uint32_t sum{};
+        for(auto p{players}; p.offset() < players.offset() + 256 * sizeof(Player); ++p)
+            sum += p->field(&Player::action).read();
+        keep(sum);
+    }) / 256.0};
+
+    std::printf("sizeof(Ref<Player, HeavyHandle>) = %zu, sizeof(HeavyHandle) = %zu\n",
+                sizeof(Ref<Player, HeavyHandle>), sizeof(HeavyHandle));
+    std::printf("%-34s %8.2f ns\n", "copy of the handle (old per step)", handle_copy);
+    std::printf("%-34s %8.2f ns\n", "ptr[i].field()[j] derivation", derive);
+    std::printf("%-34s %8.2f ns\n", "Ref passed by value + read", pass);
+    std::printf("%-34s %8.2f ns\n", "Ptr walk + field read per element", walk);
+}
@@ -0,0 +1,65 @@
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "mem64/rollback.hpp"
+#include "bench_util.hpp"
+#include "fake_handle.hpp"
+
+using namespace Mem64;
+using namespace Mem64Test;
+using namespace Mem64Bench;
+
+
+/// Save and restore latency of an 8 MB RDRAM ring for growing numbers of pages changed per frame
+template<typename THandle>
+static void run(const char* name)
+{
+    constexpr std::uint32_t SIZE{8 << 20};
+    std::vector<std::uint8_t> mem(SIZE);
+    THandle hdl{mem};
+
+    for(std::size_t dirty : {4, 64, 512})
+    {
+        RollbackRing<THandle> ring{hdl, 0, SIZE, 8};
+        std::mt19937 rng{1};
+
+        auto frame{[&]
+        {
+            for(std::size_t i{}; i < dirty; ++i)
+                mem[(rng() % (SIZE / 4096)) * 4096 + rng() % 4096] += 1;
+        }};
+
+        // Fill the ring and the page pool first
+        for(int i{}; i < 16; ++i)
+        {
+            frame();
+            ring.save();
+        }
+
+        constexpr std::size_t FRAMES{50};
+        double save_ns{}, restore_ns{};
+
+        for(std::size_t i{}; i < FRAMES; ++i)
+        {
+            frame();
+            ring.save();
+            save_ns += static_cast<double>(ring.stats().last_save.count());
+
+            // Roll back two frames and resimulate them
+            frame();
+            ring.restore(1);
+            restore_ns += static_cast<double>(ring.stats().last_restore.count());
+            frame();
+            ring.save();
+        }
+
+        std::printf("%-16s %4zu dirty pages: save %8.1f us, restore %8.1f us, %zu pool pages\n", name, dirty,
+                    save_ns / FRAMES / 1e3, restore_ns / FRAMES / 1e3, ring.stats().pool_pages);
+    }
+}
+
+int main()
+{
+    run<VecHandle>("VecHandle");
+    run<DirectVecHandle>("DirectVecHandle");
+}
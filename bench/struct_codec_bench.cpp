@@ -0,0 +1,90 @@
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "mem64/mem64.hpp"
+#include "mem64/struct_codec.hpp"
+#include "bench_util.hpp"
+#include "fake_handle.hpp"
+
+using namespace Mem64;
+using namespace Mem64Test;
+using namespace Mem64Bench;
+
+
+struct PlayerState
+{
+    std::uint32_t action;
+    std::uint32_t prev_action;
+    std::uint16_t anim_frame;
+    std::int16_t health;
+    float pos_x, pos_y, pos_z;
+    float vel_x, vel_y, vel_z;
+    std::int16_t face_angle[3];
+    std::uint16_t coins;
+    std::uint8_t stars;
+    std::uint8_t lives;
+};
+
+template<typename TCodec>
+static void add_fields(TCodec& codec, double quantum)
+{
+    codec.add_field(&PlayerState::action, FieldEncoding::XOR)
+         .add_field(&PlayerState::prev_action, FieldEncoding::XOR)
+         .add_field(&PlayerState::anim_frame)
+         .add_field(&PlayerState::health)
+         .add_field(&PlayerState::coins)
+         .add_field(&PlayerState::stars)
+         .add_field(&PlayerState::lives);
+
+    for(auto member : {&PlayerState::pos_x, &PlayerState::pos_y, &PlayerState::pos_z,
+                       &PlayerState::vel_x, &PlayerState::vel_y, &PlayerState::vel_z})
+        codec.add_field(member, FieldEncoding::DELTA, quantum);
+}
+
+/// Encode and decode throughput of a player struct with typical per frame changes, and the frame size
+int main()
+{
+    std::vector<std::uint8_t> sender_mem(0x1000), receiver_mem(0x1000);
+    VecHandle sender_hdl{sender_mem}, receiver_hdl{receiver_mem};
+    Ref<PlayerState, VecHandle> sender{sender_hdl, 0x100}, receiver{receiver_hdl, 0x100};
+
+    for(double quantum : {0.0, 0.01})
+    {
+        StructCodec<PlayerState, VecHandle> encoder, decoder;
+        add_fields(encoder, quantum);
+        add_fields(decoder, quantum);
+
+        constexpr std::size_t FRAMES{20000};
+        std::vector<std::vector<std::uint8_t>> frames(FRAMES);
+        std::mt19937 rng{1};
+        float x{}, z{};
+
+        auto encode_ns{ns_per_op(FRAMES, [&](std::size_t i)
+        {
+            // Walking: position and animation change every frame, the rest rarely
+            x += 0.8f;
+            z += static_cast<float>(rng() % 100) * 0.01f;
+            sender.field(&PlayerState::pos_x) = x;
+            sender.field(&PlayerState::pos_z) = z;
+            sender.field(&PlayerState::anim_frame) = static_cast<std::uint16_t>(i % 30);
+            if(rng() % 50 == 0)
+                sender.field(&PlayerState::coins) = static_cast<std::uint16_t>(i / 50);
+
+            encoder.encode(sender, frames[i]);
+        })};
+
+        std::size_t total{};
+        for(const auto& frame : frames)
+            total += frame.size();
+
+        std::size_t pos{};
+        auto decode_ns{ns_per_op(FRAMES, [&](std::size_t i)
+        {
+            pos += decoder.decode(frames[i].data(), frames[i].size(), receiver);
+        })};
+
+        std::printf("quantum %.2f: %zu byte struct, %.2f bytes/frame, encode %.1f ns, decode %.1f ns\n", quantum,
+                    sizeof(PlayerState), static_cast<double>(total) / FRAMES, encode_ns, decode_ns);
+        keep(pos);
+    }
+}
@@ -0,0 +1,80 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "mem64/mem64.hpp"
+#include "mem64/sync_scheduler.hpp"
+#include "bench_util.hpp"
+#include "fake_handle.hpp"
+
+using namespace Mem64;
+using namespace Mem64Test;
+using namespace Mem64Bench;
+
+
+/// Session syncing a block of game state and writing back a few inputs
+struct BenchSession
+{
+    BenchSession(std::chrono::nanoseconds latency):
+        mem(0x40000), hdl{mem, latency}, state(0x4000)
+    {}
+
+    void read()
+    {
+        hdl.read_raw(0x10000, state.data(), static_cast<std::uint32_t>(state.size()));
+    }
+
+    void write()
+    {
+        for(std::uint32_t i{}; i < 8; ++i)
+            hdl.write<std::uint32_t>(0x20000 + i * 4, state[i]);
+    }
+
+    std::vector<std::uint8_t> mem;
+    VecHandle hdl;
+    std::vector<std::uint8_t> state;
+};
+
+/// Tick time and per session latency percentiles for growing session counts and pool sizes
+int main()
+{
+    std::printf("hardware threads: %u\n", std::thread::hardware_concurrency());
+    std::printf("%8s %8s %10s %12s %12s %12s\n", "sessions", "threads", "latency", "tick us", "p50 us", "p99 us");
+
+    for(auto latency : {std::chrono::nanoseconds{}, std::chrono::nanoseconds{20000}})
+    {
+        for(std::size_t count : {16, 64, 256})
+        {
+            for(unsigned threads : {1u, 2u, 4u})
+            {
+                SyncScheduler scheduler{threads};
+                std::vector<std::unique_ptr<BenchSession>> sessions;
+
+                for(std::size_t i{}; i < count; ++i)
+                {
+                    sessions.push_back(std::make_unique<BenchSession>(latency));
+                    auto* s{sessions.back().get()};
+                    scheduler.add_session([s]{ s->read(); }, [s]{ s->write(); });
+                }
+
+                constexpr std::size_t TICKS{100};
+                auto tick_ns{ns_per_op(TICKS, [&](std::size_t){ scheduler.tick(); })};
+
+                // Worst session by p99
+                SyncScheduler::TickLatency worst{};
+                for(std::size_t id{}; id < count; ++id)
+                {
+                    auto lat{scheduler.latency(id)};
+                    if(lat.p99 > worst.p99)
+                        worst = lat;
+                }
+
+                std::printf("%8zu %8u %8lld ns %12.1f %12.1f %12.1f\n", count, threads,
+                            static_cast<long long>(latency.count()), tick_ns / 1e3, worst.p50.count() / 1e3,
+                            worst.p99.count() / 1e3);
+            }
+        }
+    }
+}
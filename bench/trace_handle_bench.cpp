@@ -0,0 +1,67 @@
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "mem64/mem64.hpp"
+#include "mem64/trace_handle.hpp"
+#include "bench_util.hpp"
+#include "fake_handle.hpp"
+
+using namespace Mem64;
+using namespace Mem64Test;
+using namespace Mem64Bench;
+
+
+/// Recording overhead of TraceHandle and replay throughput of one trace against several handles
+int main()
+{
+    constexpr std::uint32_t SIZE{8 << 20};
+    std::vector<std::uint8_t> mem(SIZE);
+
+    // Game like frame: a few hundred scalar accesses around player structs and some bulk reads
+    auto frame{[](auto& hdl, std::mt19937& rng)
+    {
+        for(int i{}; i < 300; ++i)
+        {
+            auto addr{static_cast<std::uint32_t>(0x33B170 + (rng() % 64) * 4)};
+            if(rng() % 4 == 0)
+                hdl.template write<std::uint32_t>(addr, static_cast<std::uint32_t>(rng()));
+            else
+                keep(hdl.template read<std::uint32_t>(addr));
+        }
+
+        std::uint8_t block[512];
+        for(int i{}; i < 8; ++i)
+            hdl.read_raw(static_cast<std::uint32_t>(0x200000 + (rng() % 1024) * 512), block, sizeof(block));
+    }};
+
+    constexpr int FRAMES{2000};
+
+    VecHandle plain{mem};
+    std::mt19937 plain_rng{1};
+    auto plain_ns{ns_per_op(FRAMES, [&](std::size_t){ frame(plain, plain_rng); })};
+
+    TraceLog log;
+    TraceHandle<VecHandle> traced{VecHandle{mem}, log};
+    std::mt19937 traced_rng{1};
+    auto traced_ns{ns_per_op(FRAMES, [&](std::size_t){ frame(traced, traced_rng); })};
+
+    std::printf("frame untraced %8.1f us, traced %8.1f us\n", plain_ns / 1e3, traced_ns / 1e3);
+    std::printf("log: %llu events, %.2f bytes/event\n", static_cast<unsigned long long>(log.event_count()),
+                static_cast<double>(log.byte_size()) / static_cast<double>(log.event_count()));
+
+    auto report{[](const char* name, const ReplayStats& stats)
+    {
+        std::printf("replay %-22s %8.2f Mops/s %10.1f MB/s\n", name, stats.ops_per_sec() / 1e6,
+                    stats.bytes_per_sec() / 1e6);
+    }};
+
+    VecHandle vec{mem};
+    report("VecHandle", replay(log, vec));
+
+    DirectVecHandle direct{mem};
+    report("DirectVecHandle", replay(log, direct));
+
+    VecHandle slow{mem, std::chrono::nanoseconds{500}};
+    report("VecHandle, 500 ns/call", replay(log, slow));
+}
@@ -0,0 +1,66 @@
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "mem64/mem64.hpp"
+#include "mem64/watch_list.hpp"
+#include "bench_util.hpp"
+#include "fake_handle.hpp"
+
+using namespace Mem64;
+using namespace Mem64Test;
+using namespace Mem64Bench;
+
+
+/// Poll cost of a WatchList against reading every watched Ref on its own
+int main()
+{
+    constexpr std::uint32_t SIZE{8 << 20};
+    std::vector<std::uint8_t> mem(SIZE);
+
+    std::printf("%8s %10s %8s %14s %14s %14s\n", "watches", "latency", "reads", "poll idle us", "poll 1% us",
+                "per ref us");
+
+    for(auto latency : {std::chrono::nanoseconds{}, std::chrono::nanoseconds{2000}})
+    {
+        for(std::size_t count : {100, 1000, 10000})
+        {
+            VecHandle hdl{mem, latency};
+            WatchList<VecHandle> watches{hdl};
+            std::vector<Ref<std::uint32_t, VecHandle>> refs;
+
+            // Watches clustered in a few structs like real game state
+            std::mt19937 rng{1};
+            std::size_t fired{};
+            for(std::size_t i{}; i < count; ++i)
+            {
+                auto addr{static_cast<std::uint32_t>(0x100000 + (i / 50) * 0x4000 + (rng() % 256) * 4)};
+                refs.emplace_back(hdl, addr);
+                watches.watch(refs.back(), [&](std::uint32_t, std::uint32_t){ ++fired; });
+            }
+            watches.poll();
+
+            auto iters{latency.count() ? std::size_t{20} : std::size_t{500}};
+            auto idle{ns_per_op(iters, [&](std::size_t){ watches.poll(); })};
+
+            auto busy{ns_per_op(iters, [&](std::size_t i)
+            {
+                for(std::size_t j{}; j < count / 100; ++j)
+                    refs[(i * 97 + j * 31) % count] = static_cast<std::uint32_t>(i);
+                watches.poll();
+            })};
+
+            std::uint32_t sum{};
+            auto naive{ns_per_op(iters, [&](std::size_t)
+            {
+                for(const auto& ref : refs)
+                    sum += ref.read();
+            })};
+            keep(sum);
+            keep(fired);
+
+            std::printf("%8zu %7lld ns %8zu %14.1f %14.1f %14.1f\n", count, static_cast<long long>(latency.count()),
+                        watches.read_count(), idle / 1e3, busy / 1e3, naive / 1e3);
+        }
+    }
+}
@@ -0,0 +1,348 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "reference_wrapper.hpp"
+#include "pointer_wrapper.hpp"
+
+
+namespace Mem64
+{
+
+/// Guest alignment of T on THandle
+template<typename T, typename THandle>
+constexpr typename THandle::usize_t hdl_alignof_v{
+    static_cast<typename THandle::usize_t>(is_nested_ptr_v<std::remove_all_extents_t<T>> ?
+                                           alignof(typename THandle::addr_t) : alignof(T))
+};
+
+/// Allocator for a reserved guest region, all bookkeeping is kept host side
+///
+/// Requests up to MAX_CLASS_SIZE bytes are served from power of two size class free lists which are
+/// refilled a page at a time, larger requests are placed first fit into the free ranges of the region.
+/// A page is only given to a size class while the region keeps at least another page free, small
+/// requests on small or unaligned regions are placed as single blocks into the free ranges instead.
+/// Size class pages whose blocks are all free go back to the free ranges on trim(), which runs by itself
+/// when the region cannot satisfy a request. No allocation or deallocation touches the handle.
+template<typename THandle>
+struct GuestAllocator
+{
+    using HandleType = THandle;
+    using AddrType = typename HandleType::addr_t;
+    using USizeType = typename HandleType::usize_t;
+
+    static constexpr USizeType MIN_CLASS_SIZE{8};
+    static constexpr USizeType MAX_CLASS_SIZE{1024};
+    static constexpr USizeType PAGE_SIZE{4096};
+
+
+    GuestAllocator(HandleType& hdl, AddrType base, USizeType size):
+        mem_hdl_{&hdl}
+    {
+        if(size > 0)
+        {
+            free_ranges_.emplace(base, size);
+            free_bytes_ = size;
+        }
+    }
+
+    /// Allocate a single T
+    template<typename T>
+    Ptr<T, HandleType> allocate()
+    {
+        return allocate_array<T>(1);
+    }
+
+    /// Allocate n contiguous Ts, returns an invalid Ptr if the region is exhausted
+    template<typename T>
+    Ptr<T, HandleType> allocate_array(USizeType n)
+    {
+        auto addr{allocate_raw(hdl_sizeof_v<T, HandleType> * n, hdl_alignof_v<T, HandleType>)};
+
+        if(addr == HandleType::INVALID_OFFSET)
+            return Ptr<T, HandleType>{*mem_hdl_};
+
+        return Ptr<T, HandleType>{*mem_hdl_, addr};
+    }
+
+    /// Release n Ts previously returned by allocate_array<T>(n)
+    template<typename T>
+    void deallocate(const Ptr<T, HandleType>& ptr, USizeType n = 1)
+    {
+        deallocate_raw(ptr.offset(), hdl_sizeof_v<T, HandleType> * n, hdl_alignof_v<T, HandleType>);
+    }
+
+    /// Allocate size bytes aligned to align, returns INVALID_OFFSET on failure
+    AddrType allocate_raw(USizeType size, USizeType align)
+    {
+        size = std::max<USizeType>(size, 1);
+        auto cls{size_class(size, align)};
+
+        if(cls >= CLASS_COUNT)
+        {
+            align = std::max(align, MIN_CLASS_SIZE);
+
+            auto addr{take_range(size, align)};
+            if(addr == HandleType::INVALID_OFFSET && trim())
+                addr = take_range(size, align);
+
+            if(addr != HandleType::INVALID_OFFSET)
+                used_ += size;
+            return addr;
+        }
+
+        auto& list{free_lists_[cls]};
+        if(list.empty() && !refill(cls))
+        {
+            auto addr{take_range(class_size(cls), class_size(cls))};
+            if(addr == HandleType::INVALID_OFFSET && trim())
+                addr = take_range(class_size(cls), class_size(cls));
+
+            if(addr != HandleType::INVALID_OFFSET)
+            {
+                loose_.insert(addr);
+                used_ += class_size(cls);
+            }
+            return addr;
+        }
+
+        auto addr{list.back()};
+        list.pop_back();
+        ++class_pages_[page_of(addr)];
+        used_ += class_size(cls);
+        return addr;
+    }
+
+    /// Release a block returned by allocate_raw with the same size and align
+    void deallocate_raw(AddrType addr, USizeType size, USizeType align)
+    {
+        if(addr == HandleType::INVALID_OFFSET)
+            return;
+
+        size = std::max<USizeType>(size, 1);
+        auto cls{size_class(size, align)};
+
+        if(cls >= CLASS_COUNT)
+        {
+            give_range(addr, size);
+            used_ -= size;
+        }
+        else if(!loose_.empty() && loose_.erase(addr) > 0)
+        {
+            give_range(addr, class_size(cls));
+            used_ -= class_size(cls);
+        }
+        else
+        {
+            free_lists_[cls].push_back(addr);
+            --class_pages_[page_of(addr)];
+            used_ -= class_size(cls);
+        }
+    }
+
+    /// Return size class pages without live blocks to the free ranges, returns false if there were none
+    bool trim()
+    {
+        auto empty{[this](AddrType addr){ return class_pages_.at(page_of(addr)) == 0; }};
+
+        for(auto& list : free_lists_)
+            list.erase(std::remove_if(list.begin(), list.end(), empty), list.end());
+
+        bool trimmed{};
+        for(auto it{class_pages_.begin()}; it != class_pages_.end();)
+        {
+            if(it->second > 0)
+            {
+                ++it;
+                continue;
+            }
+
+            give_range(it->first, PAGE_SIZE);
+            it = class_pages_.erase(it);
+            trimmed = true;
+        }
+
+        return trimmed;
+    }
+
+    /// Bytes currently handed out, including size class rounding
+    USizeType bytes_used() const
+    {
+        return used_;
+    }
+
+private:
+    static constexpr std::size_t CLASS_COUNT{8}; // 8 .. 1024 bytes
+
+    static constexpr USizeType class_size(std::size_t cls)
+    {
+        return MIN_CLASS_SIZE << cls;
+    }
+
+    static std::size_t size_class(USizeType size, USizeType align)
+    {
+        size = std::max(size, align);
+
+        std::size_t cls{};
+        while(cls < CLASS_COUNT && class_size(cls) < size)
+            ++cls;
+        return cls;
+    }
+
+    static AddrType page_of(AddrType addr)
+    {
+        return addr / PAGE_SIZE * PAGE_SIZE;
+    }
+
+    /// Split a fresh page into blocks of the class, blocks are aligned to their size
+    bool refill(std::size_t cls)
+    {
+        if(free_bytes_ < 2 * PAGE_SIZE)
+            return false;
+
+        auto page{take_range(PAGE_SIZE, PAGE_SIZE)};
+        if(page == HandleType::INVALID_OFFSET && trim())
+            page = take_range(PAGE_SIZE, PAGE_SIZE);
+        if(page == HandleType::INVALID_OFFSET)
+            return false;
+
+        class_pages_.emplace(page, 0);
+
+        auto& list{free_lists_[cls]};
+        for(auto offset{PAGE_SIZE}; offset > 0; offset -= class_size(cls))
+            list.push_back(page + offset - class_size(cls));
+        return true;
+    }
+
+    AddrType take_range(USizeType size, USizeType align)
+    {
+        for(auto it{free_ranges_.begin()}; it != free_ranges_.end(); ++it)
+        {
+            auto [start, len]{*it};
+            auto aligned{static_cast<AddrType>((start + align - 1) / align * align)};
+            auto pad{static_cast<USizeType>(aligned - start)};
+
+            if(aligned == HandleType::INVALID_OFFSET || len < pad || len - pad < size)
+                continue;
+
+            free_ranges_.erase(it);
+            free_bytes_ -= size;
+            if(pad > 0)
+                free_ranges_.emplace(start, pad);
+            if(len - pad > size)
+                free_ranges_.emplace(aligned + size, len - pad - size);
+            return aligned;
+        }
+
+        return HandleType::INVALID_OFFSET;
+    }
+
+    void give_range(AddrType addr, USizeType size)
+    {
+        free_bytes_ += size;
+
+        auto next{free_ranges_.lower_bound(addr)};
+
+        if(next != free_ranges_.end() && addr + size == next->first)
+        {
+            size += next->second;
+            next = free_ranges_.erase(next);
+        }
+
+        if(next != free_ranges_.begin())
+        {
+            auto prev{std::prev(next)};
+            if(prev->first + prev->second == addr)
+            {
+                prev->second += size;
+                return;
+            }
+        }
+
+        free_ranges_.emplace_hint(next, addr, size);
+    }
+
+    HandleType* mem_hdl_;
+    std::array<std::vector<AddrType>, CLASS_COUNT> free_lists_;
+    std::map<AddrType, USizeType> free_ranges_;
+    std::unordered_map<AddrType, std::size_t> class_pages_; ///< Live blocks per size class page
+    std::unordered_set<AddrType> loose_;                    ///< Small blocks taken outside of class pages
+    USizeType free_bytes_{};
+    USizeType used_{};
+};
+
+/// Bump allocator over a guest region, everything is released at once by reset()
+template<typename THandle>
+struct FrameArena
+{
+    using HandleType = THandle;
+    using AddrType = typename HandleType::addr_t;
+    using USizeType = typename HandleType::usize_t;
+
+
+    FrameArena(HandleType& hdl, AddrType base, USizeType size):
+        mem_hdl_{&hdl}, base_{base}, size_{size}
+    {}
+
+    template<typename T>
+    Ptr<T, HandleType> allocate()
+    {
+        return allocate_array<T>(1);
+    }
+
+    /// Allocate n contiguous Ts, returns an invalid Ptr if the arena is full
+    template<typename T>
+    Ptr<T, HandleType> allocate_array(USizeType n)
+    {
+        auto addr{allocate_raw(hdl_sizeof_v<T, HandleType> * n, hdl_alignof_v<T, HandleType>)};
+
+        if(addr == HandleType::INVALID_OFFSET)
+            return Ptr<T, HandleType>{*mem_hdl_};
+
+        return Ptr<T, HandleType>{*mem_hdl_, addr};
+    }
+
+    /// Allocate size bytes aligned to align, returns INVALID_OFFSET without using any space on failure
+    AddrType allocate_raw(USizeType size, USizeType align)
+    {
+        align = std::max<USizeType>(align, 1);
+        auto aligned{static_cast<AddrType>((base_ + top_ + align - 1) / align * align)};
+
+        // INVALID_OFFSET cannot be handed out, skip to the next aligned address
+        if(aligned == HandleType::INVALID_OFFSET)
+            aligned = static_cast<AddrType>(aligned + align);
+
+        auto offset{static_cast<USizeType>(aligned - base_)};
+
+        if(offset > size_ || size_ - offset < size)
+            return HandleType::INVALID_OFFSET;
+
+        top_ = offset + size;
+        return aligned;
+    }
+
+    /// Release every allocation of the arena
+    void reset()
+    {
+        top_ = 0;
+    }
+
+    USizeType bytes_used() const
+    {
+        return top_;
+    }
+
+private:
+    HandleType* mem_hdl_;
+    AddrType base_;
+    USizeType size_;
+    USizeType top_{};
+};
+
+} // Mem64
@@ -0,0 +1,247 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include "handle_traits.hpp"
+
+
+namespace Mem64
+{
+
+/// Bulk oriented virtual interface behind AnyHandle
+struct HandleInterface
+{
+    using addr_t = std::uint64_t;
+    using usize_t = std::uint64_t;
+
+    struct ReadVec
+    {
+        addr_t offset;
+        std::uint8_t* data;
+        usize_t n;
+    };
+
+    struct WriteVec
+    {
+        addr_t offset;
+        const std::uint8_t* data;
+        usize_t n;
+    };
+
+    virtual ~HandleInterface() = default;
+
+    virtual void read_raw(addr_t offset, std::uint8_t data[], usize_t n) = 0;
+    virtual void write_raw(addr_t offset, const std::uint8_t data[], usize_t n) = 0;
+
+    /// Scatter reads, backends that can batch requests should override this
+    virtual void read_vec(const ReadVec vecs[], std::size_t count)
+    {
+        for(std::size_t i{}; i < count; ++i)
+            read_raw(vecs[i].offset, vecs[i].data, vecs[i].n);
+    }
+
+    /// Gather writes, backends that can batch requests should override this
+    virtual void write_vec(const WriteVec vecs[], std::size_t count)
+    {
+        for(std::size_t i{}; i < count; ++i)
+            write_raw(vecs[i].offset, vecs[i].data, vecs[i].n);
+    }
+};
+
+template<typename THandle>
+struct HandleModel final : HandleInterface
+{
+    using AddrType = typename THandle::addr_t;
+    using USizeType = typename THandle::usize_t;
+
+    explicit HandleModel(THandle hdl):
+        hdl_{std::move(hdl)}
+    {}
+
+    void read_raw(addr_t offset, std::uint8_t data[], usize_t n) override
+    {
+        hdl_.read_raw(static_cast<AddrType>(offset), data, static_cast<USizeType>(n));
+    }
+
+    void write_raw(addr_t offset, const std::uint8_t data[], usize_t n) override
+    {
+        hdl_.write_raw(static_cast<AddrType>(offset), data, static_cast<USizeType>(n));
+    }
+
+    THandle& get()
+    {
+        return hdl_;
+    }
+
+private:
+    THandle hdl_;
+};
+
+/// Type erased handle for backends chosen at runtime
+///
+/// Scalar reads can be served from a small direct mapped cache of recently read lines, so only a
+/// miss pays a virtual call. The cache is off by default, enable_cache() turns it on for one region
+/// that must be readable as a whole. Line fetches are clamped to that region and reads outside it go
+/// straight to the backend. Writes go straight through and update cached lines. The cache does not
+/// see changes made by the guest, call invalidate_cache() whenever guest memory may have changed,
+/// e.g. once per frame.
+struct AnyHandle
+{
+    using addr_t = HandleInterface::addr_t;
+    using saddr_t = std::int64_t;
+    using usize_t = HandleInterface::usize_t;
+    using ssize_t = std::int64_t;
+
+    static constexpr addr_t INVALID_OFFSET{0};
+
+    static constexpr usize_t LINE_SIZE{64};
+    static constexpr std::size_t LINE_COUNT{8};
+
+
+    template<typename THandle, typename = std::enable_if_t<!std::is_same_v<std::decay_t<THandle>, AnyHandle>>>
+    explicit AnyHandle(THandle hdl):
+        swap_{raw_bytes_swapped(hdl)},
+        impl_{std::make_unique<HandleModel<THandle>>(std::move(hdl))}
+    {
+        invalidate_cache();
+    }
+
+    /// Byte order of the backend, forwarded to hdl_decode/hdl_encode users
+    bool swaps_bytes() const
+    {
+        return swap_;
+    }
+
+    void read_raw(addr_t offset, std::uint8_t data[], usize_t n)
+    {
+        impl_->read_raw(offset, data, n);
+    }
+
+    void write_raw(addr_t offset, const std::uint8_t data[], usize_t n)
+    {
+        impl_->write_raw(offset, data, n);
+        update_cache(offset, data, n);
+    }
+
+    void read_vec(const HandleInterface::ReadVec vecs[], std::size_t count)
+    {
+        impl_->read_vec(vecs, count);
+    }
+
+    void write_vec(const HandleInterface::WriteVec vecs[], std::size_t count)
+    {
+        impl_->write_vec(vecs, count);
+        for(std::size_t i{}; i < count; ++i)
+            update_cache(vecs[i].offset, vecs[i].data, vecs[i].n);
+    }
+
+    template<typename T>
+    T read(addr_t offset)
+    {
+        static_assert(std::is_fundamental_v<T> || std::is_enum_v<T>);
+
+        auto line{offset / LINE_SIZE},
+             pos{offset % LINE_SIZE};
+
+        if(offset < cache_begin_ || offset + sizeof(T) > cache_end_ || pos + sizeof(T) > LINE_SIZE)
+        {
+            std::uint8_t bytes[sizeof(T)];
+            impl_->read_raw(offset, bytes, sizeof(T));
+            return decode_raw<T>(bytes, swap_);
+        }
+
+        auto& slot{slots_[line % LINE_COUNT]};
+        if(slot.tag != line)
+        {
+            auto begin{std::max(line * LINE_SIZE, cache_begin_)},
+                 end{std::min(line * LINE_SIZE + LINE_SIZE, cache_end_)};
+            impl_->read_raw(begin, slot.data.data() + (begin - line * LINE_SIZE), end - begin);
+            slot.tag = line;
+        }
+
+        return decode_raw<T>(slot.data.data() + pos, swap_);
+    }
+
+    template<typename T>
+    void write(addr_t offset, T val)
+    {
+        static_assert(std::is_fundamental_v<T> || std::is_enum_v<T>);
+
+        std::uint8_t bytes[sizeof(T)];
+        encode_raw<T>(val, bytes, swap_);
+        write_raw(offset, bytes, sizeof(T));
+    }
+
+    template<typename T>
+    static bool valid_offset(addr_t offset)
+    {
+        return (offset != INVALID_OFFSET) && (offset % alignof(T) == 0);
+    }
+
+    /// Cache scalar reads within [begin, begin + size), the whole region must be readable
+    void enable_cache(addr_t begin, usize_t size)
+    {
+        cache_begin_ = begin;
+        cache_end_ = begin + size;
+        invalidate_cache();
+    }
+
+    void disable_cache()
+    {
+        cache_begin_ = cache_end_ = 0;
+        invalidate_cache();
+    }
+
+    /// Drop all cached lines
+    void invalidate_cache()
+    {
+        for(auto& slot : slots_)
+            slot.tag = INVALID_TAG;
+    }
+
+    /// Access the concrete handle, returns nullptr if the backend is not a THandle
+    template<typename THandle>
+    THandle* get()
+    {
+        auto* model{dynamic_cast<HandleModel<THandle>*>(impl_.get())};
+        return model ? &model->get() : nullptr;
+    }
+
+private:
+    static constexpr addr_t INVALID_TAG{~addr_t{}};
+
+    struct Line
+    {
+        addr_t tag;
+        std::array<std::uint8_t, LINE_SIZE> data;
+    };
+
+    void update_cache(addr_t offset, const std::uint8_t data[], usize_t n)
+    {
+        for(auto& slot : slots_)
+        {
+            if(slot.tag == INVALID_TAG)
+                continue;
+
+            auto line_begin{slot.tag * LINE_SIZE},
+                 begin{std::max(offset, line_begin)},
+                 end{std::min(offset + n, line_begin + LINE_SIZE)};
+
+            if(begin < end)
+                std::copy(data + (begin - offset), data + (end - offset), slot.data.begin() + (begin - line_begin));
+        }
+    }
+
+    bool swap_;
+    std::unique_ptr<HandleInterface> impl_;
+    addr_t cache_begin_{};
+    addr_t cache_end_{};
+    std::array<Line, LINE_COUNT> slots_;
+};
+
+} // Mem64
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <string>
+#include <string_view>
 #include "reference_common.hpp"
+#include "cstring.hpp"
 
 
 namespace Mem64
@@ -16,19 +19,43 @@ struct Ref<TType, THandle,
     using HandleType = typename Traits::HandleType;
     using AddrType = typename Traits::AddrType;
     using USizeType = typename Traits::USizeType;
+    using RawType = typename Traits::RawType;
     using QualifiedType = typename Traits::QualifiedType;
 
+    #define CHAR_ARRAY_ONLY_ template<typename T = RawType, \
+                             typename = std::enable_if_t<std::is_same_v<std::remove_extent_t<T>, char>>>
+    #define MUTABLE_CHAR_ARRAY_ONLY_ template<typename T = RawType, \
+                             typename = std::enable_if_t<std::is_same_v<std::remove_extent_t<T>, char> && \
+                                                         !Traits::IS_CONST>>
 
-    explicit Ref(const HandleType& hdl, AddrType addr = HandleType::INVALID_OFFSET):
+
+    explicit Ref(HandleType& hdl, AddrType addr = HandleType::INVALID_OFFSET):
     RefBase<Ref<TType, THandle>>(hdl, addr)
     {}
 
     Ref<std::remove_extent_t<QualifiedType>, HandleType> operator[](USizeType i) const
     {
         return Ref<std::remove_extent_t<QualifiedType>, HandleType>{
-            this->mem_hdl_, this->addr_ + hdl_sizeof_v<std::remove_extent_t<QualifiedType>, HandleType> * i
+            *this->mem_hdl_, this->addr_ + hdl_sizeof_v<std::remove_extent_t<QualifiedType>, HandleType> * i
         };
     }
+
+    /// View the string stored in a char array, buf is reused between calls
+    CHAR_ARRAY_ONLY_
+    std::string_view str(std::string& buf) const
+    {
+        return read_fixed_str(*this->mem_hdl_, this->addr_, buf, std::extent_v<RawType>);
+    }
+
+    /// Store str in a char array, truncated so the terminating NUL always fits
+    MUTABLE_CHAR_ARRAY_ONLY_
+    void assign(std::string_view str) const
+    {
+        write_cstr(*this->mem_hdl_, this->addr_, str, std::extent_v<RawType>);
+    }
+
+    #undef CHAR_ARRAY_ONLY_
+    #undef MUTABLE_CHAR_ARRAY_ONLY_
 };
 
 } // Mem64
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "handle_traits.hpp"
+
+
+namespace Mem64
+{
+
+struct CopyOptions
+{
+    /// Bytes transferred per read_raw/write_raw pair
+    std::size_t chunk_size{64 * 1024};
+
+    /// Read the next chunk on a separate thread while the current one is written
+    bool pipelined{false};
+};
+
+namespace detail
+{
+
+template<typename TSrcHandle, typename TDstHandle>
+void copy_chunked(TSrcHandle& src_hdl, typename TSrcHandle::addr_t src_addr,
+                  TDstHandle& dst_hdl, typename TDstHandle::addr_t dst_addr,
+                  std::size_t n, std::size_t chunk_size)
+{
+    std::vector<std::uint8_t> buf(std::min(chunk_size, n));
+
+    for(std::size_t pos{}; pos < n; pos += buf.size())
+    {
+        auto len{std::min(buf.size(), n - pos)};
+        src_hdl.read_raw(src_addr + static_cast<typename TSrcHandle::addr_t>(pos), buf.data(),
+                         static_cast<typename TSrcHandle::usize_t>(len));
+        dst_hdl.write_raw(dst_addr + static_cast<typename TDstHandle::addr_t>(pos), buf.data(),
+                          static_cast<typename TDstHandle::usize_t>(len));
+    }
+}
+
+/// Double buffered copy, a reader thread fills one buffer while the calling thread drains the other
+template<typename TSrcHandle, typename TDstHandle>
+void copy_pipelined(TSrcHandle& src_hdl, typename TSrcHandle::addr_t src_addr,
+                    TDstHandle& dst_hdl, typename TDstHandle::addr_t dst_addr,
+                    std::size_t n, std::size_t chunk_size)
+{
+    struct Slot
+    {
+        std::vector<std::uint8_t> data;
+        std::size_t len{};
+        bool full{};
+    };
+
+    Slot slots[2];
+    slots[0].data.resize(chunk_size);
+    slots[1].data.resize(chunk_size);
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool abort{};
+    std::exception_ptr reader_error;
+
+    std::thread reader{[&]
+    {
+        try
+        {
+            std::size_t i{};
+            for(std::size_t pos{}; pos < n; pos += chunk_size, i ^= 1)
+            {
+                {
+                    std::unique_lock lock{mtx};
+                    cv.wait(lock, [&]{ return !slots[i].full || abort; });
+                    if(abort)
+                        return;
+                }
+
+                auto len{std::min(chunk_size, n - pos)};
+                src_hdl.read_raw(src_addr + static_cast<typename TSrcHandle::addr_t>(pos), slots[i].data.data(),
+                                 static_cast<typename TSrcHandle::usize_t>(len));
+
+                std::lock_guard lock{mtx};
+                slots[i].len = len;
+                slots[i].full = true;
+                cv.notify_all();
+            }
+        }
+        catch(...)
+        {
+            std::lock_guard lock{mtx};
+            reader_error = std::current_exception();
+            abort = true;
+            cv.notify_all();
+        }
+    }};
+
+    try
+    {
+        std::size_t i{};
+        for(std::size_t pos{}; pos < n; i ^= 1)
+        {
+            {
+                std::unique_lock lock{mtx};
+                cv.wait(lock, [&]{ return slots[i].full || abort; });
+                if(abort)
+                    break;
+            }
+
+            dst_hdl.write_raw(dst_addr + static_cast<typename TDstHandle::addr_t>(pos), slots[i].data.data(),
+                              static_cast<typename TDstHandle::usize_t>(slots[i].len));
+            pos += slots[i].len;
+
+            std::lock_guard lock{mtx};
+            slots[i].full = false;
+            cv.notify_all();
+        }
+    }
+    catch(...)
+    {
+        {
+            std::lock_guard lock{mtx};
+            abort = true;
+            cv.notify_all();
+        }
+        reader.join();
+        throw;
+    }
+
+    reader.join();
+    if(reader_error)
+        std::rethrow_exception(reader_error);
+}
+
+} // detail
+
+/// Copy n bytes from src_addr of src_hdl to dst_addr of dst_hdl
+///
+/// If both handles have direct access the copy is a single memmove, if one side has direct access
+/// the other side reads/writes straight into host memory. Otherwise the transfer is split into
+/// chunks, optionally pipelined. Regions on non direct access handles must not overlap.
+template<typename TSrcHandle, typename TDstHandle>
+void copy(TSrcHandle& src_hdl, typename TSrcHandle::addr_t src_addr,
+          TDstHandle& dst_hdl, typename TDstHandle::addr_t dst_addr,
+          std::size_t n, const CopyOptions& opts = {})
+{
+    if(n == 0)
+        return;
+
+    if constexpr(has_direct_access_v<TSrcHandle> && has_direct_access_v<TDstHandle>)
+    {
+        std::memmove(dst_hdl.host_ptr(dst_addr), src_hdl.host_ptr(src_addr), n);
+    }
+    else if constexpr(has_direct_access_v<TSrcHandle>)
+    {
+        dst_hdl.write_raw(dst_addr, src_hdl.host_ptr(src_addr), static_cast<typename TDstHandle::usize_t>(n));
+    }
+    else if constexpr(has_direct_access_v<TDstHandle>)
+    {
+        src_hdl.read_raw(src_addr, dst_hdl.host_ptr(dst_addr), static_cast<typename TSrcHandle::usize_t>(n));
+    }
+    else
+    {
+        auto chunk_size{std::max<std::size_t>(opts.chunk_size, 1)};
+
+        if(opts.pipelined && n > chunk_size)
+            detail::copy_pipelined(src_hdl, src_addr, dst_hdl, dst_addr, n, chunk_size);
+        else
+            detail::copy_chunked(src_hdl, src_addr, dst_hdl, dst_addr, n, chunk_size);
+    }
+}
+
+} // Mem64
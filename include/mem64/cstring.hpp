@@ -0,0 +1,177 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include "handle_traits.hpp"
+#include "reference_common.hpp"
+
+
+namespace Mem64
+{
+
+/// Bytes fetched per read_raw while searching for the terminator, chunks never cross a multiple of this
+constexpr std::size_t CSTR_CHUNK_SIZE{64};
+
+/// Read a terminated guest string of at most max_len bytes into buf
+///
+/// Reads are chunked and aligned so they never run past the block containing the terminator.
+/// The returned view points into buf and stays valid until buf is modified.
+template<typename THandle>
+std::string_view read_cstr(THandle& hdl, typename THandle::addr_t addr, std::string& buf,
+                           std::size_t max_len, std::uint8_t terminator = 0)
+{
+    using AddrType = typename THandle::addr_t;
+    using USizeType = typename THandle::usize_t;
+
+    buf.clear();
+
+    if constexpr(has_direct_access_v<THandle>)
+    {
+        auto* data{hdl.host_ptr(addr)};
+        auto* end{static_cast<const std::uint8_t*>(std::memchr(data, terminator, max_len))};
+        buf.assign(reinterpret_cast<const char*>(data), end ? static_cast<std::size_t>(end - data) : max_len);
+    }
+    else
+    {
+        std::array<std::uint8_t, CSTR_CHUNK_SIZE> chunk;
+
+        for(std::size_t pos{}; pos < max_len;)
+        {
+            auto cur{static_cast<AddrType>(addr + pos)};
+            auto len{std::min(CSTR_CHUNK_SIZE - static_cast<std::size_t>(cur % CSTR_CHUNK_SIZE), max_len - pos)};
+            hdl.read_raw(cur, chunk.data(), static_cast<USizeType>(len));
+
+            auto* end{static_cast<const std::uint8_t*>(std::memchr(chunk.data(), terminator, len))};
+            auto found{end ? static_cast<std::size_t>(end - chunk.data()) : len};
+            buf.append(reinterpret_cast<const char*>(chunk.data()), found);
+
+            if(end)
+                break;
+            pos += len;
+        }
+    }
+
+    return buf;
+}
+
+/// Read a string stored in a fixed size guest buffer of n bytes with a single transfer
+template<typename THandle>
+std::string_view read_fixed_str(THandle& hdl, typename THandle::addr_t addr, std::string& buf,
+                                std::size_t n, std::uint8_t terminator = 0)
+{
+    buf.resize(n);
+    hdl.read_raw(addr, reinterpret_cast<std::uint8_t*>(buf.data()), static_cast<typename THandle::usize_t>(n));
+
+    auto* end{static_cast<const char*>(std::memchr(buf.data(), terminator, n))};
+    if(end)
+        buf.resize(static_cast<std::size_t>(end - buf.data()));
+
+    return buf;
+}
+
+/// Write str to a guest buffer of capacity bytes, truncating so the terminator always fits
+template<typename THandle>
+void write_cstr(THandle& hdl, typename THandle::addr_t addr, std::string_view str,
+                std::size_t capacity, std::uint8_t terminator = 0)
+{
+    if(capacity == 0)
+        return;
+
+    auto len{std::min(str.size(), capacity - 1)};
+
+    if constexpr(has_direct_access_v<THandle>)
+    {
+        auto* data{hdl.host_ptr(addr)};
+        std::memcpy(data, str.data(), len);
+        data[len] = terminator;
+    }
+    else
+    {
+        std::string tmp(str.substr(0, len));
+        tmp.push_back(static_cast<char>(terminator));
+        hdl.write_raw(addr, reinterpret_cast<const std::uint8_t*>(tmp.data()),
+                      static_cast<typename THandle::usize_t>(tmp.size()));
+    }
+}
+
+/// Read a terminated string through a Ptr<char>
+template<typename T, typename THandle,
+         typename = std::enable_if_t<std::is_same_v<std::remove_cv_t<T>, char>>>
+std::string_view read_cstr(const Ptr<T, THandle>& ptr, std::string& buf, std::size_t max_len,
+                           std::uint8_t terminator = 0)
+{
+    return read_cstr(*ptr.hdl(), ptr.offset(), buf, max_len, terminator);
+}
+
+/// Write a terminated string through a Ptr<char>
+template<typename THandle>
+void write_cstr(const Ptr<char, THandle>& ptr, std::string_view str, std::size_t capacity,
+                std::uint8_t terminator = 0)
+{
+    write_cstr(*ptr.hdl(), ptr.offset(), str, capacity, terminator);
+}
+
+
+/// Byte translation table for guest text that does not use ASCII
+struct TextTable
+{
+    /// decode maps every guest byte to a host character, unmapped host characters encode to fallback
+    TextTable(const std::array<char, 256>& decode, std::uint8_t terminator, std::uint8_t fallback):
+        decode_{decode}, terminator_{terminator}
+    {
+        encode_.fill(fallback);
+        for(std::size_t i{decode_.size()}; i-- > 0;)
+            encode_[static_cast<unsigned char>(decode_[i])] = static_cast<std::uint8_t>(i);
+    }
+
+    /// Translate guest bytes to host characters in place
+    void decode(std::string& str) const
+    {
+        for(auto& c : str)
+            c = decode_[static_cast<unsigned char>(c)];
+    }
+
+    /// Translate host characters to guest bytes in place
+    void encode(std::string& str) const
+    {
+        for(auto& c : str)
+            c = static_cast<char>(encode_[static_cast<unsigned char>(c)]);
+    }
+
+    std::uint8_t terminator() const
+    {
+        return terminator_;
+    }
+
+private:
+    std::array<char, 256> decode_;
+    std::array<std::uint8_t, 256> encode_;
+    std::uint8_t terminator_;
+};
+
+/// Read guest text of at most max_len bytes and translate it with table
+template<typename THandle>
+std::string_view read_text(THandle& hdl, typename THandle::addr_t addr, std::string& buf,
+                           std::size_t max_len, const TextTable& table)
+{
+    read_cstr(hdl, addr, buf, max_len, table.terminator());
+    table.decode(buf);
+    return buf;
+}
+
+/// Translate str with table and write it to a guest buffer of capacity bytes
+template<typename THandle>
+void write_text(THandle& hdl, typename THandle::addr_t addr, std::string_view str,
+                std::size_t capacity, const TextTable& table)
+{
+    std::string tmp(str);
+    table.encode(tmp);
+    write_cstr(hdl, addr, tmp, capacity, table.terminator());
+}
+
+} // Mem64
@@ -19,7 +19,7 @@ struct Ref<TType, THandle,
     using RawType = typename Traits::RawType;
     using QualifiedType = typename Traits::QualifiedType;
 
-    explicit Ref(const HandleType& hdl, AddrType addr = HandleType::INVALID_OFFSET):
+    explicit Ref(HandleType& hdl, AddrType addr = HandleType::INVALID_OFFSET):
     RefBase<Ref<TType, THandle>>(hdl, addr)
     {}
 
@@ -30,15 +30,15 @@ struct Ref<TType, THandle,
 
     void write(const RawType& val) const
     {
-        this->mem_hdl_.template write<RawType>(this->addr_, val);
+        this->mem_hdl_->template write<RawType>(this->addr_, val);
     }
 
     RawType read() const
     {
-        return this->mem_hdl_.template read<RawType>(this->addr_);
+        return this->mem_hdl_->template read<RawType>(this->addr_);
     }
 
-    #define MUTABLE_ONLY_ template<typename = std::enable_if_t<!RefTraits<Ref<QualifiedType, HandleType>>::IS_CONST>>
+    #define MUTABLE_ONLY_ template<typename T = QualifiedType, typename = std::enable_if_t<!std::is_const_v<T>>>
 
     MUTABLE_ONLY_
     RawType operator=(const RawType& other) const
@@ -166,7 +166,7 @@ struct Ref<TType, THandle,
         return (read() >> pos);
     }
 
-
+    MUTABLE_ONLY_
     RawType operator<<=(std::size_t pos) const
     {
         RawType val{read() << pos};
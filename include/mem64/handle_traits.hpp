@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+
+namespace Mem64
+{
+
+/// Check if THandle can hand out host pointers into its memory via host_ptr(addr_t)
+template<typename THandle, typename = void>
+struct has_direct_access : std::false_type
+{};
+
+template<typename THandle>
+struct has_direct_access<THandle, std::void_t<
+    decltype(std::declval<THandle&>().host_ptr(std::declval<typename THandle::addr_t>()))>>
+    : std::is_same<decltype(std::declval<THandle&>().host_ptr(std::declval<typename THandle::addr_t>())),
+                   std::uint8_t*>
+{};
+
+template<typename THandle>
+constexpr bool has_direct_access_v{has_direct_access<THandle>::value};
+
+
+/// Check if the raw bytes of THandle are byte swapped relative to its read<T>/write<T> values
+///
+/// Handles for big endian guests on little endian hosts declare static constexpr bool SWAP_BYTES{true}.
+template<typename THandle, typename = void>
+struct hdl_swaps_bytes : std::false_type
+{};
+
+template<typename THandle>
+struct hdl_swaps_bytes<THandle, std::void_t<decltype(THandle::SWAP_BYTES)>>
+    : std::bool_constant<THandle::SWAP_BYTES>
+{};
+
+template<typename THandle>
+constexpr bool hdl_swaps_bytes_v{hdl_swaps_bytes<THandle>::value};
+
+/// Check if THandle only knows its byte order at runtime and reports it via bool swaps_bytes() const
+template<typename THandle, typename = void>
+struct has_runtime_byte_order : std::false_type
+{};
+
+template<typename THandle>
+struct has_runtime_byte_order<THandle, std::void_t<decltype(std::declval<const THandle&>().swaps_bytes())>>
+    : std::true_type
+{};
+
+template<typename THandle>
+constexpr bool has_runtime_byte_order_v{has_runtime_byte_order<THandle>::value};
+
+/// Check if the raw bytes of hdl are byte swapped relative to its read<T>/write<T> values
+template<typename THandle>
+bool raw_bytes_swapped(const THandle& hdl)
+{
+    if constexpr(has_runtime_byte_order_v<THandle>)
+        return hdl.swaps_bytes();
+    else
+        return hdl_swaps_bytes_v<THandle>;
+}
+
+
+/// Reverse the bytes of a fundamental or enum value
+template<typename T>
+T byte_swap(T val)
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    std::uint8_t bytes[sizeof(T)];
+    std::memcpy(bytes, &val, sizeof(T));
+    for(std::size_t i{}; i < sizeof(T) / 2; ++i)
+    {
+        auto tmp{bytes[i]};
+        bytes[i] = bytes[sizeof(T) - 1 - i];
+        bytes[sizeof(T) - 1 - i] = tmp;
+    }
+    std::memcpy(&val, bytes, sizeof(T));
+    return val;
+}
+
+/// Decode T from raw bytes, reversing them if swap is set
+template<typename T>
+T decode_raw(const std::uint8_t* data, bool swap)
+{
+    T val;
+    std::memcpy(&val, data, sizeof(T));
+    return swap ? byte_swap(val) : val;
+}
+
+/// Encode val into raw bytes, reversing them if swap is set
+template<typename T>
+void encode_raw(T val, std::uint8_t* data, bool swap)
+{
+    if(swap)
+        val = byte_swap(val);
+    std::memcpy(data, &val, sizeof(T));
+}
+
+/// Decode the value hdl.read<T> would return from raw bytes
+template<typename T, typename THandle>
+T hdl_decode(const THandle& hdl, const std::uint8_t* data)
+{
+    return decode_raw<T>(data, raw_bytes_swapped(hdl));
+}
+
+/// Encode val into the raw bytes hdl.write<T> would store
+template<typename T, typename THandle>
+void hdl_encode(const THandle& hdl, T val, std::uint8_t* data)
+{
+    encode_raw<T>(val, data, raw_bytes_swapped(hdl));
+}
+
+} // Mem64
@@ -0,0 +1,376 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <numeric>
+#include <type_traits>
+#include "handle_traits.hpp"
+#include "reference_wrapper.hpp"
+
+
+namespace Mem64
+{
+
+/// Leaves closer than this are fetched by the same read_raw
+constexpr std::size_t LAZY_FUSE_GAP{32};
+
+/// Largest span a single fused read may cover
+constexpr std::size_t LAZY_FUSE_LIMIT{128};
+
+namespace detail
+{
+
+template<typename THandle>
+struct LazySlot
+{
+    THandle* hdl;
+    typename THandle::addr_t addr;
+    std::size_t size;
+    std::uint8_t raw[8];
+};
+
+struct NoSlot
+{};
+
+} // detail
+
+template<typename TDerived>
+struct LazyExpr;
+
+template<typename T>
+constexpr bool is_lazy_v{std::is_base_of_v<LazyExpr<T>, T>};
+
+template<typename TExpr, typename = std::enable_if_t<is_lazy_v<TExpr>>>
+auto eval(const TExpr& expr);
+
+/// Base of all lazy expression nodes
+template<typename TDerived>
+struct LazyExpr
+{
+    /// Fetch all operands together and evaluate
+    auto value() const
+    {
+        return eval(static_cast<const TDerived&>(*this));
+    }
+
+    explicit operator bool() const
+    {
+        return static_cast<bool>(value());
+    }
+};
+
+/// Constant operand
+template<typename T>
+struct LazyValue : LazyExpr<LazyValue<T>>
+{
+    using HandleType = void;
+    using ValueType = T;
+    static constexpr std::size_t LEAVES{0};
+
+    explicit LazyValue(T val):
+        val_{val}
+    {}
+
+    template<typename TSlot>
+    void collect(TSlot*) const
+    {}
+
+    template<typename TSlot>
+    T evaluate(const TSlot*) const
+    {
+        return val_;
+    }
+
+private:
+    T val_;
+};
+
+/// Ref operand, read when the whole expression is evaluated
+template<typename TRef>
+struct LazyRef : LazyExpr<LazyRef<TRef>>
+{
+    using HandleType = typename TRef::HandleType;
+    using ValueType = typename TRef::RawType;
+    static constexpr std::size_t LEAVES{1};
+
+    static_assert(std::is_fundamental_v<ValueType> || std::is_enum_v<ValueType>);
+    static_assert(sizeof(ValueType) <= sizeof(detail::LazySlot<HandleType>::raw));
+
+    explicit LazyRef(const TRef& ref):
+        ref_{ref}
+    {}
+
+    void collect(detail::LazySlot<HandleType>* slots) const
+    {
+        slots[0].hdl = &ref_.hdl();
+        slots[0].addr = ref_.offset();
+        slots[0].size = sizeof(ValueType);
+    }
+
+    ValueType evaluate(const detail::LazySlot<HandleType>* slots) const
+    {
+        return hdl_decode<ValueType>(*slots[0].hdl, slots[0].raw);
+    }
+
+private:
+    TRef ref_;
+};
+
+namespace detail
+{
+
+template<typename L, typename R>
+using lazy_common_handle_t = std::conditional_t<std::is_void_v<L>, R, L>;
+
+template<typename L, typename R>
+constexpr bool lazy_handles_compatible_v{std::is_void_v<L> || std::is_void_v<R> || std::is_same_v<L, R>};
+
+template<typename TOp>
+constexpr bool lazy_keeps_raw_type_v{
+    std::is_same_v<TOp, std::plus<>> || std::is_same_v<TOp, std::minus<>> ||
+    std::is_same_v<TOp, std::multiplies<>> || std::is_same_v<TOp, std::divides<>> ||
+    std::is_same_v<TOp, std::modulus<>> || std::is_same_v<TOp, std::bit_and<>> ||
+    std::is_same_v<TOp, std::bit_or<>> || std::is_same_v<TOp, std::bit_xor<>> ||
+    std::is_same_v<TOp, std::negate<>> || std::is_same_v<TOp, std::bit_not<>>
+};
+
+template<typename T>
+struct LazyType
+{
+    using type = T;
+};
+
+/// Arithmetic keeps the raw type like the eager Ref operators instead of promoting, constants take
+/// the type of the other operand and two Ref operands use their common type
+template<typename TOp, typename L, typename R>
+auto lazy_binary_value()
+{
+    if constexpr(!lazy_keeps_raw_type_v<TOp>)
+        return LazyType<bool>{};
+    else if constexpr(is_instantiation_of_v<LazyValue, L>)
+        return LazyType<typename R::ValueType>{};
+    else if constexpr(is_instantiation_of_v<LazyValue, R>)
+        return LazyType<typename L::ValueType>{};
+    else
+        return LazyType<std::common_type_t<typename L::ValueType, typename R::ValueType>>{};
+}
+
+template<typename TOp, typename L, typename R>
+using lazy_binary_value_t = typename decltype(lazy_binary_value<TOp, L, R>())::type;
+
+} // detail
+
+template<typename TOp, typename L, typename R>
+struct LazyBinary : LazyExpr<LazyBinary<TOp, L, R>>
+{
+    static_assert(detail::lazy_handles_compatible_v<typename L::HandleType, typename R::HandleType>,
+                  "All Refs of a lazy expression must use the same handle type");
+
+    using HandleType = detail::lazy_common_handle_t<typename L::HandleType, typename R::HandleType>;
+    using ValueType = detail::lazy_binary_value_t<TOp, L, R>;
+    static constexpr std::size_t LEAVES{L::LEAVES + R::LEAVES};
+
+    LazyBinary(const L& lhs, const R& rhs):
+        lhs_{lhs}, rhs_{rhs}
+    {}
+
+    template<typename TSlot>
+    void collect(TSlot* slots) const
+    {
+        lhs_.collect(slots);
+        rhs_.collect(slots + L::LEAVES);
+    }
+
+    /// && and || short circuit like their builtin versions, the right side is fetched but not evaluated
+    template<typename TSlot>
+    ValueType evaluate(const TSlot* slots) const
+    {
+        if constexpr(std::is_same_v<TOp, std::logical_and<>>)
+            return static_cast<bool>(lhs_.evaluate(slots)) && static_cast<bool>(rhs_.evaluate(slots + L::LEAVES));
+        else if constexpr(std::is_same_v<TOp, std::logical_or<>>)
+            return static_cast<bool>(lhs_.evaluate(slots)) || static_cast<bool>(rhs_.evaluate(slots + L::LEAVES));
+        else if constexpr(detail::lazy_keeps_raw_type_v<TOp>)
+            return static_cast<ValueType>(TOp{}(static_cast<ValueType>(lhs_.evaluate(slots)),
+                                                static_cast<ValueType>(rhs_.evaluate(slots + L::LEAVES))));
+        else
+            return TOp{}(lhs_.evaluate(slots), rhs_.evaluate(slots + L::LEAVES));
+    }
+
+private:
+    L lhs_;
+    R rhs_;
+};
+
+template<typename TOp, typename E>
+struct LazyUnary : LazyExpr<LazyUnary<TOp, E>>
+{
+    using HandleType = typename E::HandleType;
+    using ValueType = std::conditional_t<detail::lazy_keeps_raw_type_v<TOp>, typename E::ValueType, bool>;
+    static constexpr std::size_t LEAVES{E::LEAVES};
+
+    explicit LazyUnary(const E& expr):
+        expr_{expr}
+    {}
+
+    template<typename TSlot>
+    void collect(TSlot* slots) const
+    {
+        expr_.collect(slots);
+    }
+
+    template<typename TSlot>
+    ValueType evaluate(const TSlot* slots) const
+    {
+        return static_cast<ValueType>(TOp{}(expr_.evaluate(slots)));
+    }
+
+private:
+    E expr_;
+};
+
+
+/// Start a lazy expression, Refs combined with it are fetched together on evaluation
+///
+/// Only operators with a lazy operand build expressions. A bare action == IDLE still uses the eager
+/// Ref operator and reads right away, so wrap every comparison in lazy(), e.g.
+/// lazy(action) == IDLE && lazy(timer) > 0. Arithmetic results keep the raw type of the Refs like the
+/// eager operators do.
+template<typename T, typename THandle>
+LazyRef<Ref<T, THandle>> lazy(const Ref<T, THandle>& ref)
+{
+    return LazyRef<Ref<T, THandle>>{ref};
+}
+
+namespace detail
+{
+
+template<typename T>
+auto as_lazy(const T& val)
+{
+    if constexpr(is_lazy_v<T>)
+        return val;
+    else if constexpr(is_instantiation_of_v<Ref, T>)
+        return LazyRef<T>{val};
+    else
+        return LazyValue<T>{val};
+}
+
+template<typename T>
+using as_lazy_t = decltype(as_lazy(std::declval<const T&>()));
+
+/// Read all slots, neighbouring slots of the same handle share one read_raw
+template<typename THandle, std::size_t N>
+void lazy_fetch(std::array<LazySlot<THandle>, N>& slots)
+{
+    std::array<std::size_t, N> order;
+    std::iota(order.begin(), order.end(), std::size_t{});
+    std::sort(order.begin(), order.end(), [&](auto a, auto b)
+    {
+        return slots[a].hdl != slots[b].hdl ? std::less<>{}(slots[a].hdl, slots[b].hdl) : slots[a].addr < slots[b].addr;
+    });
+
+    std::uint8_t buf[LAZY_FUSE_LIMIT];
+
+    for(std::size_t first{}; first < N;)
+    {
+        const auto& head{slots[order[first]]};
+        auto begin{head.addr},
+             end{static_cast<decltype(begin)>(head.addr + head.size)};
+
+        auto last{first + 1};
+        for(; last < N; ++last)
+        {
+            const auto& next{slots[order[last]]};
+            auto next_end{static_cast<decltype(begin)>(next.addr + next.size)};
+
+            if(next.hdl != head.hdl || next.addr > end + LAZY_FUSE_GAP ||
+               std::max(end, next_end) - begin > LAZY_FUSE_LIMIT)
+                break;
+
+            end = std::max(end, next_end);
+        }
+
+        if(last - first == 1)
+        {
+            auto& slot{slots[order[first]]};
+            slot.hdl->read_raw(slot.addr, slot.raw, static_cast<typename THandle::usize_t>(slot.size));
+        }
+        else
+        {
+            head.hdl->read_raw(begin, buf, static_cast<typename THandle::usize_t>(end - begin));
+            for(auto i{first}; i < last; ++i)
+            {
+                auto& slot{slots[order[i]]};
+                std::memcpy(slot.raw, buf + (slot.addr - begin), slot.size);
+            }
+        }
+
+        first = last;
+    }
+}
+
+} // detail
+
+/// Collect every Ref of expr, fetch them in as few reads as possible and evaluate
+template<typename TExpr, typename>
+auto eval(const TExpr& expr)
+{
+    using HandleType = typename TExpr::HandleType;
+
+    if constexpr(TExpr::LEAVES == 0)
+    {
+        return expr.evaluate(static_cast<const detail::NoSlot*>(nullptr));
+    }
+    else
+    {
+        std::array<detail::LazySlot<HandleType>, TExpr::LEAVES> slots;
+        expr.collect(slots.data());
+        detail::lazy_fetch(slots);
+        return expr.evaluate(static_cast<const detail::LazySlot<HandleType>*>(slots.data()));
+    }
+}
+
+#define MEM64_LAZY_BINARY_(OP, FUNCTOR) \
+    template<typename L, typename R, typename = std::enable_if_t<is_lazy_v<L> || is_lazy_v<R>>> \
+    LazyBinary<FUNCTOR, detail::as_lazy_t<L>, detail::as_lazy_t<R>> operator OP(const L& lhs, const R& rhs) \
+    { \
+        return {detail::as_lazy(lhs), detail::as_lazy(rhs)}; \
+    }
+
+MEM64_LAZY_BINARY_(+, std::plus<>)
+MEM64_LAZY_BINARY_(-, std::minus<>)
+MEM64_LAZY_BINARY_(*, std::multiplies<>)
+MEM64_LAZY_BINARY_(/, std::divides<>)
+MEM64_LAZY_BINARY_(%, std::modulus<>)
+MEM64_LAZY_BINARY_(&, std::bit_and<>)
+MEM64_LAZY_BINARY_(|, std::bit_or<>)
+MEM64_LAZY_BINARY_(^, std::bit_xor<>)
+MEM64_LAZY_BINARY_(==, std::equal_to<>)
+MEM64_LAZY_BINARY_(!=, std::not_equal_to<>)
+MEM64_LAZY_BINARY_(<, std::less<>)
+MEM64_LAZY_BINARY_(<=, std::less_equal<>)
+MEM64_LAZY_BINARY_(>, std::greater<>)
+MEM64_LAZY_BINARY_(>=, std::greater_equal<>)
+MEM64_LAZY_BINARY_(&&, std::logical_and<>)
+MEM64_LAZY_BINARY_(||, std::logical_or<>)
+
+#undef MEM64_LAZY_BINARY_
+
+#define MEM64_LAZY_UNARY_(OP, FUNCTOR) \
+    template<typename E, typename = std::enable_if_t<is_lazy_v<E>>> \
+    LazyUnary<FUNCTOR, E> operator OP(const E& expr) \
+    { \
+        return LazyUnary<FUNCTOR, E>{expr}; \
+    }
+
+MEM64_LAZY_UNARY_(-, std::negate<>)
+MEM64_LAZY_UNARY_(!, std::logical_not<>)
+MEM64_LAZY_UNARY_(~, std::bit_not<>)
+
+#undef MEM64_LAZY_UNARY_
+
+} // Mem64
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <type_traits>
 
@@ -13,9 +14,15 @@ struct NativeHandle
     using addr_t = std::uintptr_t;
     using saddr_t = std::intptr_t;
     using usize_t = std::size_t;
-    using ssize_t = std::ssize_t;
+    using ssize_t = std::ptrdiff_t;
 
-    static constexpr addr_t INVALID_OFFSET{static_cast<addr_t>(nullptr)};
+    static constexpr addr_t INVALID_OFFSET{0};
+
+    /// Host pointer to offset, native memory is directly addressable
+    std::uint8_t* host_ptr(addr_t offset)
+    {
+        return reinterpret_cast<std::uint8_t*>(offset);
+    }
 
     /// Read n bytes from offset
     void read_raw(addr_t offset, std::uint8_t data[], usize_t n)
@@ -33,7 +40,7 @@ struct NativeHandle
     template<typename T>
     T read(addr_t offset)
     {
-        static_assert(std::is_fundamental_v(T));
+        static_assert(std::is_fundamental_v<T>);
         return *reinterpret_cast<const T*>(offset);
     }
 
@@ -41,7 +48,7 @@ struct NativeHandle
     template<typename T>
     void write(addr_t offset, T val)
     {
-        static_assert(std::is_fundamental_v(T));
+        static_assert(std::is_fundamental_v<T>);
         *reinterpret_cast<T*>(offset) = val;
     }
 
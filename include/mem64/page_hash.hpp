@@ -0,0 +1,323 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "pin.hpp"
+
+
+namespace Mem64
+{
+
+namespace detail
+{
+
+constexpr std::uint64_t HASH_PRIME_1{0x9E3779B185EBCA87ull};
+constexpr std::uint64_t HASH_PRIME_2{0xC2B2AE3D27D4EB4Full};
+constexpr std::uint64_t HASH_PRIME_3{0x165667B19E3779F9ull};
+
+inline std::uint64_t rotl64(std::uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+inline std::uint64_t load64(const std::uint8_t* p)
+{
+    std::uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/// Fast non cryptographic 64 bit hash, four independent lanes so the main loop vectorizes
+inline std::uint64_t hash_bytes(const std::uint8_t* data, std::size_t n, std::uint64_t seed = 0)
+{
+    std::uint64_t acc[4]{seed + HASH_PRIME_1, seed + HASH_PRIME_2, seed, seed - HASH_PRIME_1};
+    std::size_t pos{};
+
+    for(; pos + 32 <= n; pos += 32)
+    {
+        for(int i = 0; i < 4; ++i)
+            acc[i] = rotl64(acc[i] + load64(data + pos + 8 * i) * HASH_PRIME_2, 31) * HASH_PRIME_1;
+    }
+
+    std::uint64_t h{rotl64(acc[0], 1) + rotl64(acc[1], 7) + rotl64(acc[2], 12) + rotl64(acc[3], 18)};
+    h += static_cast<std::uint64_t>(n);
+
+    for(; pos + 8 <= n; pos += 8)
+        h = rotl64(h ^ (load64(data + pos) * HASH_PRIME_2), 27) * HASH_PRIME_1 + HASH_PRIME_3;
+
+    for(; pos < n; ++pos)
+        h = rotl64(h ^ (data[pos] * HASH_PRIME_3), 11) * HASH_PRIME_1;
+
+    h ^= h >> 33;
+    h *= HASH_PRIME_2;
+    h ^= h >> 29;
+    h *= HASH_PRIME_3;
+    h ^= h >> 32;
+    return h;
+}
+
+/// Fixed set of threads that run numbered tasks together with the calling thread
+struct WorkerPool
+{
+    /// Spawn extra_threads threads, run() also uses the calling thread
+    explicit WorkerPool(unsigned extra_threads)
+    {
+        for(unsigned i{}; i < extra_threads; ++i)
+            threads_.emplace_back([this]{ loop(); });
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard lock{mtx_};
+            stop_ = true;
+        }
+        work_cv_.notify_all();
+
+        for(auto& t : threads_)
+            t.join();
+    }
+
+    /// Call fn(i) for every i < tasks and wait for all of them, rethrows the first exception
+    void run(std::size_t tasks, const std::function<void(std::size_t)>& fn)
+    {
+        {
+            std::lock_guard lock{mtx_};
+            job_ = &fn;
+            tasks_ = tasks;
+            next_ = 0;
+            checked_in_ = 0;
+            ++generation_;
+        }
+        work_cv_.notify_all();
+
+        work(fn, tasks);
+
+        // Every thread checks in once per generation, so none still touches fn afterwards
+        std::unique_lock lock{mtx_};
+        done_cv_.wait(lock, [this]{ return checked_in_ == threads_.size(); });
+        job_ = nullptr;
+
+        if(error_)
+            std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+
+    std::size_t thread_count() const
+    {
+        return threads_.size() + 1;
+    }
+
+private:
+    void work(const std::function<void(std::size_t)>& fn, std::size_t tasks)
+    {
+        for(auto i{next_.fetch_add(1)}; i < tasks; i = next_.fetch_add(1))
+        {
+            try
+            {
+                fn(i);
+            }
+            catch(...)
+            {
+                std::lock_guard lock{mtx_};
+                if(!error_)
+                    error_ = std::current_exception();
+            }
+        }
+    }
+
+    void loop()
+    {
+        std::uint64_t seen{};
+
+        for(;;)
+        {
+            const std::function<void(std::size_t)>* fn;
+            std::size_t tasks;
+            {
+                std::unique_lock lock{mtx_};
+                work_cv_.wait(lock, [&]{ return stop_ || generation_ != seen; });
+                if(stop_)
+                    return;
+                seen = generation_;
+                fn = job_;
+                tasks = tasks_;
+            }
+
+            work(*fn, tasks);
+
+            std::lock_guard lock{mtx_};
+            if(++checked_in_ == threads_.size())
+                done_cv_.notify_all();
+        }
+    }
+
+    std::vector<std::thread> threads_;
+    std::mutex mtx_;
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+    const std::function<void(std::size_t)>* job_{};
+    std::size_t tasks_{};
+    std::atomic<std::size_t> next_{};
+    std::size_t checked_in_{};
+    std::uint64_t generation_{};
+    bool stop_{};
+    std::exception_ptr error_;
+};
+
+} // detail
+
+/// Keeps a hash per page of a guest region and reports which pages changed since the last update
+template<typename THandle>
+struct PageHashIndex
+{
+    using HandleType = THandle;
+    using AddrType = typename HandleType::addr_t;
+    using USizeType = typename HandleType::usize_t;
+
+    static constexpr USizeType PAGE_SIZE{4096};
+
+    /// Pages read per read_raw call on handles without direct access, others are hashed in place
+    static constexpr std::size_t PAGES_PER_READ{16};
+
+    /// Minimum number of pages a worker thread has to hash to be worth using
+    static constexpr std::size_t MIN_PAGES_PER_THREAD{256};
+
+
+    /// The worker threads are started here and kept until destruction, update() never spawns threads
+    PageHashIndex(HandleType& hdl, AddrType base, USizeType size, unsigned threads = 1):
+        mem_hdl_{&hdl}, base_{base}, size_{size},
+        hashes_((size + PAGE_SIZE - 1) / PAGE_SIZE),
+        dirty_((hashes_.size() + 63) / 64),
+        pool_{static_cast<unsigned>(std::min<std::size_t>(std::max(threads, 1u),
+                                                          std::max<std::size_t>(hashes_.size() / MIN_PAGES_PER_THREAD, 1))) - 1}
+    {
+        scratch_.resize(pool_.thread_count());
+    }
+
+    /// Rehash all pages and start a new epoch, returns the dirty page bitmap of this epoch
+    ///
+    /// Every page is dirty on the first update. With more than one thread the handle has to
+    /// tolerate concurrent read_raw calls.
+    const std::vector<std::uint64_t>& update()
+    {
+        std::size_t words{dirty_.size()},
+                    workers{pool_.thread_count()};
+
+        if(workers <= 1)
+        {
+            hash_words(0, words, scratch_[0]);
+        }
+        else
+        {
+            // Split on bitmap words so no two threads touch the same word
+            std::size_t per_task{(words + workers - 1) / workers};
+
+            // Small enough a capture for std::function to store without allocating
+            pool_.run(workers, [this, per_task](std::size_t task)
+            {
+                auto words{dirty_.size()},
+                     first{std::min(task * per_task, words)};
+                hash_words(first, std::min(first + per_task, words), scratch_[task]);
+            });
+        }
+
+        initialized_ = true;
+        ++epoch_;
+        return dirty_;
+    }
+
+    const std::vector<std::uint64_t>& dirty_bitmap() const
+    {
+        return dirty_;
+    }
+
+    bool dirty(std::size_t page) const
+    {
+        return (dirty_[page / 64] >> (page % 64)) & 1u;
+    }
+
+    std::size_t page_count() const
+    {
+        return hashes_.size();
+    }
+
+    AddrType page_addr(std::size_t page) const
+    {
+        return base_ + static_cast<AddrType>(page * PAGE_SIZE);
+    }
+
+    std::uint64_t epoch() const
+    {
+        return epoch_;
+    }
+
+    /// Forget all hashes, the next update reports every page dirty
+    void reset()
+    {
+        initialized_ = false;
+    }
+
+private:
+    std::size_t page_len(std::size_t page) const
+    {
+        return std::min<std::size_t>(PAGE_SIZE, size_ - page * PAGE_SIZE);
+    }
+
+    /// Every task passes its own scratch, it is kept across updates
+    void hash_words(std::size_t first_word, std::size_t last_word, std::vector<std::uint8_t>& scratch)
+    {
+        std::size_t first{first_word * 64},
+                    last{std::min(last_word * 64, page_count())};
+
+        std::fill(dirty_.begin() + first_word, dirty_.begin() + last_word, 0);
+
+        if(first >= last)
+            return;
+
+        auto len{(last - first - 1) * PAGE_SIZE + page_len(last - 1)};
+
+        // Chunks are whole pages, so every chunk starts on a page boundary
+        visit_bytes(*mem_hdl_, page_addr(first), len, PAGES_PER_READ * PAGE_SIZE, scratch,
+                    [&](std::size_t offset, const std::uint8_t* data, std::size_t n)
+        {
+            for(std::size_t pos{}; pos < n; pos += PAGE_SIZE)
+            {
+                auto page{first + (offset + pos) / PAGE_SIZE};
+                store(page, detail::hash_bytes(data + pos, page_len(page)));
+            }
+        });
+    }
+
+    void store(std::size_t page, std::uint64_t hash)
+    {
+        if(!initialized_ || hashes_[page] != hash)
+            dirty_[page / 64] |= std::uint64_t{1} << (page % 64);
+
+        hashes_[page] = hash;
+    }
+
+    HandleType* mem_hdl_;
+    AddrType base_;
+    USizeType size_;
+    std::vector<std::uint64_t> hashes_;
+    std::vector<std::uint64_t> dirty_;
+    std::vector<std::vector<std::uint8_t>> scratch_;
+    std::uint64_t epoch_{};
+    bool initialized_{};
+    detail::WorkerPool pool_;
+};
+
+} // Mem64
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "handle_traits.hpp"
+
+
+namespace Mem64
+{
+
+/// Host view of n Ts of guest memory
+///
+/// On handles with direct access this points straight into guest memory. Otherwise the elements are
+/// copied in on construction and changes only reach guest memory through flush(), a Pin that is just
+/// destroyed never writes back. Elements are in the raw byte order of the handle, so byte swapping
+/// handles only pin single bytes, use a Pin of std::uint8_t or visit_bytes for their raw bytes.
+/// Handles that only know their byte order at runtime throw std::invalid_argument instead.
+template<typename T, typename THandle>
+struct Pin
+{
+    using HandleType = THandle;
+    using AddrType = typename HandleType::addr_t;
+    using USizeType = typename HandleType::usize_t;
+    using RawType = std::remove_cv_t<T>;
+
+    static constexpr bool ZERO_COPY{has_direct_access_v<HandleType>};
+
+    // Guest pointers are not host pointers
+    static_assert(!std::is_pointer_v<RawType>, "pin guest pointers as their addr_t");
+
+    // Multi-byte elements would be read in the wrong byte order
+    static_assert(sizeof(RawType) == 1 || !hdl_swaps_bytes_v<HandleType>,
+                  "byte swapping handles only pin bytes, use Pin<std::uint8_t> or visit_bytes");
+
+
+    Pin(HandleType& hdl, AddrType addr, std::size_t n):
+        mem_hdl_{&hdl}, addr_{addr}, size_{n}
+    {
+        if constexpr(sizeof(RawType) > 1 && has_runtime_byte_order_v<HandleType>)
+        {
+            if(hdl.swaps_bytes())
+                throw std::invalid_argument{"byte swapping handles only pin bytes"};
+        }
+
+        if constexpr(ZERO_COPY)
+        {
+            data_ = reinterpret_cast<T*>(hdl.host_ptr(addr));
+        }
+        else
+        {
+            copy_.resize(n);
+            hdl.read_raw(addr, reinterpret_cast<std::uint8_t*>(copy_.data()), static_cast<USizeType>(size_bytes()));
+            data_ = copy_.data();
+        }
+    }
+
+    Pin(const Pin&) = delete;
+    Pin& operator=(const Pin&) = delete;
+
+    Pin(Pin&& other) noexcept:
+        mem_hdl_{other.mem_hdl_}, addr_{other.addr_}, size_{other.size_},
+        data_{other.data_}, copy_{std::move(other.copy_)}
+    {
+        if constexpr(!ZERO_COPY)
+            data_ = copy_.data();
+
+        other.mem_hdl_ = nullptr;
+    }
+
+    /// Write the copy back, no-op for zero copy pins
+    void flush()
+    {
+        static_assert(!std::is_const_v<T>, "read only pins cannot be flushed");
+
+        if constexpr(!ZERO_COPY)
+        {
+            if(mem_hdl_ && size_ > 0)
+                mem_hdl_->write_raw(addr_, reinterpret_cast<const std::uint8_t*>(copy_.data()),
+                                    static_cast<USizeType>(size_bytes()));
+        }
+    }
+
+    T* data() const
+    {
+        return data_;
+    }
+
+    std::size_t size() const
+    {
+        return size_;
+    }
+
+    std::size_t size_bytes() const
+    {
+        return size_ * sizeof(T);
+    }
+
+    T* begin() const
+    {
+        return data_;
+    }
+
+    T* end() const
+    {
+        return data_ + size_;
+    }
+
+    T& operator[](std::size_t i) const
+    {
+        return data_[i];
+    }
+
+    std::conditional_t<std::is_const_v<T>, const std::uint8_t*, std::uint8_t*> bytes() const
+    {
+        return reinterpret_cast<std::conditional_t<std::is_const_v<T>, const std::uint8_t*, std::uint8_t*>>(data_);
+    }
+
+private:
+    HandleType* mem_hdl_;
+    AddrType addr_;
+    std::size_t size_;
+    T* data_{};
+    std::vector<RawType> copy_;
+};
+
+/// Hand n bytes at addr to fn(offset, data, len) in pieces of at most chunk_size bytes
+///
+/// Handles with direct access pass guest memory in a single call without copying, other handles
+/// are read chunk by chunk into scratch, which only grows if it is smaller than one chunk.
+template<typename THandle, typename TFn>
+void visit_bytes(THandle& hdl, typename THandle::addr_t addr, std::size_t n, std::size_t chunk_size,
+                 std::vector<std::uint8_t>& scratch, TFn&& fn)
+{
+    if(n == 0)
+        return;
+
+    if constexpr(has_direct_access_v<THandle>)
+    {
+        fn(std::size_t{}, static_cast<const std::uint8_t*>(hdl.host_ptr(addr)), n);
+    }
+    else
+    {
+        auto chunk{std::min(std::max<std::size_t>(chunk_size, 1), n)};
+        if(scratch.size() < chunk)
+            scratch.resize(chunk);
+
+        for(std::size_t pos{}; pos < n; pos += chunk)
+        {
+            auto len{std::min(chunk, n - pos)};
+            hdl.read_raw(addr + static_cast<typename THandle::addr_t>(pos), scratch.data(),
+                         static_cast<typename THandle::usize_t>(len));
+            fn(pos, static_cast<const std::uint8_t*>(scratch.data()), len);
+        }
+    }
+}
+
+/// visit_bytes with a buffer of its own, allocates on every call for handles without direct access
+template<typename THandle, typename TFn>
+void visit_bytes(THandle& hdl, typename THandle::addr_t addr, std::size_t n, std::size_t chunk_size, TFn&& fn)
+{
+    std::vector<std::uint8_t> scratch;
+    visit_bytes(hdl, addr, n, chunk_size, scratch, std::forward<TFn>(fn));
+}
+
+} // Mem64
@@ -23,13 +23,13 @@ struct Ref<TType, THandle, std::enable_if_t<is_nested_ptr_v<TType>>>
     static constexpr USizeType SIZE{Traits::SIZE};
 
 
-    Ref(const HandleType& hdl, AddrType addr):
-    mem_hdl_{hdl}, addr_{addr}
+    /// Only points to the handle, it has to outlive the Ref
+    Ref(HandleType& hdl, AddrType addr):
+    mem_hdl_{&hdl}, addr_{addr}
     {}
 
     Ref& operator=(const Ref& other)
     {
-        mem_hdl_ = other.mem_hdl_;
         write(other.offset());
 
         return *this;
@@ -37,7 +37,6 @@ struct Ref<TType, THandle, std::enable_if_t<is_nested_ptr_v<TType>>>
 
     Ref& operator=(const PtrType& other)
     {
-        mem_hdl_ = other.mem_hdl_;
         write(other.offset());
 
         return *this;
@@ -45,22 +44,22 @@ struct Ref<TType, THandle, std::enable_if_t<is_nested_ptr_v<TType>>>
 
     operator PtrType() const
     {
-        return {mem_hdl_, read()};
+        return PtrType{*mem_hdl_, read()};
     }
 
     Ptr<QualifiedType, HandleType> ptr() const
     {
-        return {mem_hdl_, addr_};
+        return Ptr<QualifiedType, HandleType>{*mem_hdl_, addr_};
     }
 
-    void set_hdl(const HandleType& hdl)
+    void set_hdl(HandleType& hdl)
     {
-        mem_hdl_ = hdl;
+        mem_hdl_ = &hdl;
     }
 
-    HandleType hdl() const
+    HandleType& hdl() const
     {
-        return mem_hdl_;
+        return *mem_hdl_;
     }
 
     void set_offset(AddrType addr) const
@@ -85,40 +84,40 @@ struct Ref<TType, THandle, std::enable_if_t<is_nested_ptr_v<TType>>>
 
     Ref<remove_nested_ptr_t<QualifiedType>, HandleType> operator*() const
     {
-        return {mem_hdl_, read()};
+        return Ref<remove_nested_ptr_t<QualifiedType>, HandleType>{*mem_hdl_, read()};
     }
 
     Ref<remove_nested_ptr_t<QualifiedType>, HandleType> operator[](USizeType index) const
     {
-        return Ref<remove_nested_ptr_t<QualifiedType>, HandleType>{mem_hdl_, read() + index * SIZE};
+        return Ref<remove_nested_ptr_t<QualifiedType>, HandleType>{*mem_hdl_, read() + index * SIZE};
     }
 
     OperatorProxy<Ref<remove_nested_ptr_t<QualifiedType>, HandleType>>
     operator->() const
     {
-        return Ref<QualifiedType, HandleType>{mem_hdl_, read()};
+        return Ref<remove_nested_ptr_t<QualifiedType>, HandleType>{*mem_hdl_, read()};
     }
 
     #define IF_CONVERTIBLE_ template<typename T, typename = \
                             std::enable_if_t<std::is_convertible_v<remove_nested_ptr_t<QualifiedType>, T>>>
-    #define MUTABLE_ONLY_ template<typename = std::enable_if_t<!std::is_const_v<QualifiedType>>>
+    #define MUTABLE_ONLY_ template<typename U = QualifiedType, typename = std::enable_if_t<!std::is_const_v<U>>>
 
     IF_CONVERTIBLE_
     explicit operator Ptr<T, HandleType>() const
     {
-        return {mem_hdl_, read()};
+        return Ptr<T, HandleType>{*mem_hdl_, read()};
     }
 
     IF_CONVERTIBLE_
     bool operator==(const Ref<T, HandleType>& other) const
     {
-        return (mem_hdl_ == other.mem_hdl_ && read() == other.read());
+        return (mem_hdl_ == &other.hdl() && read() == other.offset());
     }
 
     IF_CONVERTIBLE_
     bool operator==(const Ptr<T, HandleType>& other) const
     {
-        return (mem_hdl_ == other.mem_hdl_ && read() == other.addr_);
+        return (mem_hdl_ == other.hdl() && read() == other.offset());
     }
 
     IF_CONVERTIBLE_
@@ -136,19 +135,19 @@ struct Ref<TType, THandle, std::enable_if_t<is_nested_ptr_v<TType>>>
 
     PtrType operator+(SSizeType n) const
     {
-        return {mem_hdl_, read() + SIZE * n};
+        return PtrType{*mem_hdl_, read() + SIZE * n};
     }
 
     PtrType operator-(SSizeType n) const
     {
-        return {mem_hdl_, read() - SIZE * n};
+        return PtrType{*mem_hdl_, read() - SIZE * n};
     }
 
     MUTABLE_ONLY_
     PtrType operator+=(SSizeType n) const
     {
         write(read() + SIZE * n);
-        return static_cast<Ptr<QualifiedType, HandleType>>(*this);
+        return static_cast<PtrType>(*this);
     }
 
     MUTABLE_ONLY_
@@ -194,15 +193,15 @@ struct Ref<TType, THandle, std::enable_if_t<is_nested_ptr_v<TType>>>
 private:
     AddrType read() const
     {
-        return mem_hdl_.template read<AddrType>(addr_);
+        return mem_hdl_->template read<AddrType>(addr_);
     }
 
     void write(AddrType val) const
     {
-        mem_hdl_.template write<AddrType>(addr_, val);
+        mem_hdl_->template write<AddrType>(addr_, val);
     }
 
-    mutable HandleType mem_hdl_;
+    HandleType* mem_hdl_;
     AddrType addr_;
 };
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <type_traits>
+#include "pin.hpp"
 #include "util.hpp"
 
 
@@ -20,21 +21,22 @@ struct Ptr
     static constexpr USizeType SIZE{Traits::SIZE};
 
     Ptr():
-        mem_hdl_(),
+        mem_hdl_(nullptr),
         addr_(HandleType::INVALID_OFFSET)
     {}
 
-    explicit Ptr(const HandleType& hdl):
-        mem_hdl_{hdl}, addr_{HandleType::INVALID_OFFSET}
+    /// Only points to the handle, it has to outlive the Ptr
+    explicit Ptr(HandleType& hdl):
+        mem_hdl_{&hdl}, addr_{HandleType::INVALID_OFFSET}
     {}
 
-    Ptr(const HandleType& hdl, AddrType addr):
-        mem_hdl_{hdl}, addr_{addr}
+    Ptr(HandleType& hdl, AddrType addr):
+        mem_hdl_{&hdl}, addr_{addr}
     {}
 
-    void set_hdl(std::optional<HandleType> hdl)
+    void set_hdl(HandleType* hdl)
     {
-        mem_hdl_ = std::move(hdl);
+        mem_hdl_ = hdl;
     }
 
     void set_offset(AddrType addr)
@@ -44,11 +46,11 @@ struct Ptr
 
     void invalidate()
     {
-        mem_hdl_ = {};
+        mem_hdl_ = nullptr;
         addr_ = HandleType::INVALID_OFFSET;
     }
 
-    std::optional<HandleType> hdl() const
+    HandleType* hdl() const
     {
         return mem_hdl_;
     }
@@ -60,17 +62,31 @@ struct Ptr
 
     bool valid() const
     {
-        return HandleType::template valid_offset<QualifiedType>(addr_) && mem_hdl_.has_value();
+        return HandleType::template valid_offset<QualifiedType>(addr_) && mem_hdl_ != nullptr;
     }
 
     Ref<QualifiedType, HandleType> operator*() const
     {
-        return {*mem_hdl_, addr_};
+        return Ref<QualifiedType, HandleType>{*mem_hdl_, addr_};
     }
 
     Ref<QualifiedType, HandleType> operator[](USizeType i) const
     {
-        return {*mem_hdl_, addr_ + SIZE * i};
+        return Ref<QualifiedType, HandleType>{*mem_hdl_, addr_ + SIZE * i};
+    }
+
+    /// Read only host view of n elements starting at the pointee
+    Pin<const QualifiedType, HandleType> span(USizeType n) const
+    {
+        static_assert(SIZE == sizeof(QualifiedType));
+        return Pin<const QualifiedType, HandleType>{*mem_hdl_, addr_, n};
+    }
+
+    /// Writable host view, changes have to be written back with flush()
+    Pin<typename Traits::RawType, HandleType> span_mut(USizeType n) const
+    {
+        static_assert(SIZE == sizeof(QualifiedType));
+        return Pin<typename Traits::RawType, HandleType>{*mem_hdl_, addr_, n};
     }
 
     OperatorProxy<Ref<QualifiedType, HandleType>>
@@ -79,18 +95,21 @@ struct Ptr
         return Ref<QualifiedType, HandleType>{*mem_hdl_, addr_};
     }
 
-    #define IF_CONVERTIBLE_ template<typename T, std::enable_if_t<std::is_convertible_v<QualifiedType*, T>>>
+    #define IF_CONVERTIBLE_ template<typename T, typename = std::enable_if_t<std::is_convertible_v<QualifiedType*, T*>>>
 
     IF_CONVERTIBLE_
     explicit operator Ptr<T, HandleType>() const
     {
-        return {mem_hdl_, addr_};
+        Ptr<T, HandleType> ptr;
+        ptr.set_hdl(mem_hdl_);
+        ptr.set_offset(addr_);
+        return ptr;
     }
 
     IF_CONVERTIBLE_
     bool operator==(const Ptr<T, HandleType>& other) const
     {
-        return (mem_hdl_ == other.mem_hdl_ && addr_ == other.addr_);
+        return (mem_hdl_ == other.hdl() && addr_ == other.offset());
     }
 
     IF_CONVERTIBLE_
@@ -102,12 +121,16 @@ struct Ptr
 
     Ptr operator+(SSizeType n) const
     {
-        return {mem_hdl_, addr_ + SIZE * n};
+        auto ptr{*this};
+        ptr.addr_ += SIZE * n;
+        return ptr;
     }
 
     Ptr operator-(SSizeType n) const
     {
-        return {mem_hdl_, addr_ - SIZE * n};
+        auto ptr{*this};
+        ptr.addr_ -= SIZE * n;
+        return ptr;
     }
 
     Ptr operator+=(SSizeType n)
@@ -131,7 +154,7 @@ struct Ptr
     const Ptr operator++(int)
     {
         auto old{*this};
-        *this++;
+        ++*this;
         return old;
     }
 
@@ -144,14 +167,14 @@ struct Ptr
     const Ptr operator--(int)
     {
         auto old{*this};
-        *this--;
+        --*this;
         return old;
     }
 
     #undef IF_CONVERTIBLE_
 
 private:
-    std::optional<HandleType> mem_hdl_;
+    HandleType* mem_hdl_;
     AddrType addr_;
 };
 
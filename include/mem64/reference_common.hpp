@@ -1,6 +1,7 @@
 #pragma once
 
 #include <type_traits>
+#include "pin.hpp"
 #include "util.hpp"
 
 
@@ -118,20 +119,51 @@ struct RefBase
 
     operator typename Traits::template Rebind<const RawType>() const
     {
-        return {mem_hdl_, addr_};
+        return typename Traits::template Rebind<const RawType>{*mem_hdl_, addr_};
     }
 
     Ptr<QualifiedType, HandleType> ptr() const
     {
-        return Ptr<QualifiedType, HandleType>{mem_hdl_, addr_};
+        return Ptr<QualifiedType, HandleType>{*mem_hdl_, addr_};
+    }
+
+    HandleType& hdl() const
+    {
+        return *mem_hdl_;
+    }
+
+    AddrType offset() const
+    {
+        return addr_;
+    }
+
+    /// Read only host view of the referenced object, arrays are pinned as all their elements
+    auto pin() const
+    {
+        return make_pin<const std::remove_all_extents_t<QualifiedType>>();
+    }
+
+    /// Writable host view, changes have to be written back with flush()
+    auto pin_mut() const
+    {
+        return make_pin<std::remove_all_extents_t<QualifiedType>>();
     }
 
 private:
-    RefBase(HandleType hdl, AddrType addr):
-    mem_hdl_{hdl}, addr_{addr}
+    /// Refs only point to their handle, it has to outlive them
+    RefBase(HandleType& hdl, AddrType addr):
+    mem_hdl_{&hdl}, addr_{addr}
     {}
 
-    mutable HandleType mem_hdl_;
+    template<typename TElem>
+    Pin<TElem, HandleType> make_pin() const
+    {
+        // The host copy has to have the guest layout
+        static_assert(hdl_sizeof_v<std::remove_cv_t<TElem>, HandleType> == sizeof(TElem));
+        return Pin<TElem, HandleType>{*mem_hdl_, addr_, sizeof(QualifiedType) / sizeof(TElem)};
+    }
+
+    HandleType* mem_hdl_;
     AddrType addr_{};
 };
 
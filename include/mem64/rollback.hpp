@@ -0,0 +1,247 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "pin.hpp"
+
+
+namespace Mem64
+{
+
+/// Keeps the last few saved states of a guest region as page granular deltas
+///
+/// The newest saved state is mirrored host side, every save stores the previous content of the pages that
+/// changed since the save before. Restoring writes back only the pages that differ between the present
+/// and the restored state. Page buffers and the read buffer are kept, once the pool has grown to the
+/// working set neither saving nor restoring allocates.
+template<typename THandle>
+struct RollbackRing
+{
+    using HandleType = THandle;
+    using AddrType = typename HandleType::addr_t;
+    using USizeType = typename HandleType::usize_t;
+
+    static constexpr std::size_t PAGE_SIZE{4096};
+
+    /// Bytes read per read_raw on handles without direct access
+    static constexpr std::size_t READ_CHUNK{64 * PAGE_SIZE};
+
+    struct Stats
+    {
+        std::chrono::nanoseconds last_save{};
+        std::chrono::nanoseconds last_restore{};
+        std::size_t pages_saved{};    ///< Pages that changed in the last save
+        std::size_t pages_restored{}; ///< Pages written by the last restore
+        std::size_t pool_pages{};     ///< Page buffers allocated so far
+    };
+
+
+    /// Keep up to frames saved states of size bytes at base
+    RollbackRing(HandleType& hdl, AddrType base, USizeType size, std::size_t frames):
+        mem_hdl_{&hdl}, base_{base}, size_{size},
+        frames_(std::max<std::size_t>(frames, 1)),
+        shadow_(size),
+        page_src_((size + PAGE_SIZE - 1) / PAGE_SIZE, NO_SLOT)
+    {}
+
+    /// Save the current state as the newest frame, evicting the oldest one if the ring is full
+    void save()
+    {
+        auto start{std::chrono::steady_clock::now()};
+
+        if(count_ == frames_.size())
+        {
+            release(frames_[head_]);
+            head_ = (head_ + 1) % frames_.size();
+            --count_;
+        }
+
+        auto& frame{frames_[(head_ + count_) % frames_.size()]};
+        frame.entries.clear();
+
+        bool first{count_ == 0 && !initialized_};
+
+        visit_bytes(*mem_hdl_, base_, size_, READ_CHUNK, scratch_,
+                    [&](std::size_t offset, const std::uint8_t* data, std::size_t n)
+        {
+            if(first)
+            {
+                std::memcpy(shadow_.data() + offset, data, n);
+                return;
+            }
+
+            for(std::size_t pos{}; pos < n; pos += PAGE_SIZE)
+            {
+                auto page{(offset + pos) / PAGE_SIZE};
+                auto len{page_len(page)};
+                auto* shadow{shadow_.data() + page * PAGE_SIZE};
+
+                if(std::memcmp(shadow, data + pos, len) == 0)
+                    continue;
+
+                auto slot{acquire()};
+                std::memcpy(slot_data(slot), shadow, len);
+                std::memcpy(shadow, data + pos, len);
+                frame.entries.push_back({page, slot});
+            }
+        });
+
+        initialized_ = true;
+        ++count_;
+
+        stats_.pages_saved = frame.entries.size();
+        stats_.last_save = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    }
+
+    /// Restore the state saved frames_back saves ago, 0 is the newest save
+    ///
+    /// Frames newer than the restored one are dropped. Returns false if that frame is not kept.
+    bool restore(std::size_t frames_back)
+    {
+        if(frames_back >= count_)
+            return false;
+
+        auto start{std::chrono::steady_clock::now()};
+
+        // Oldest undo entry newer than the target holds the target content of its page
+        touched_.clear();
+        for(auto i{count_}; i-- > count_ - frames_back;)
+        {
+            for(const auto& entry : frame_at(i).entries)
+            {
+                if(page_src_[entry.page] == NO_SLOT)
+                    touched_.push_back(entry.page);
+                page_src_[entry.page] = entry.slot;
+            }
+        }
+
+        std::size_t restored{};
+
+        visit_bytes(*mem_hdl_, base_, size_, READ_CHUNK, scratch_,
+                    [&](std::size_t offset, const std::uint8_t* data, std::size_t n)
+        {
+            for(std::size_t pos{}; pos < n; pos += PAGE_SIZE)
+            {
+                auto page{(offset + pos) / PAGE_SIZE};
+                auto len{page_len(page)};
+                const auto* target{page_src_[page] == NO_SLOT ? shadow_.data() + page * PAGE_SIZE
+                                                              : slot_data(page_src_[page])};
+
+                if(std::memcmp(target, data + pos, len) == 0)
+                    continue;
+
+                mem_hdl_->write_raw(page_addr(page), target, static_cast<USizeType>(len));
+                ++restored;
+            }
+        });
+
+        // The target becomes the newest saved state
+        for(auto page : touched_)
+        {
+            std::memcpy(shadow_.data() + page * PAGE_SIZE, slot_data(page_src_[page]), page_len(page));
+            page_src_[page] = NO_SLOT;
+        }
+
+        for(; frames_back > 0; --frames_back)
+            release(frame_at(--count_));
+
+        stats_.pages_restored = restored;
+        stats_.last_restore = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        return true;
+    }
+
+    /// Number of saved states that can be restored
+    std::size_t frame_count() const
+    {
+        return count_;
+    }
+
+    std::size_t capacity() const
+    {
+        return frames_.size();
+    }
+
+    const Stats& stats() const
+    {
+        return stats_;
+    }
+
+private:
+    static constexpr std::size_t NO_SLOT{~std::size_t{}};
+
+    struct Entry
+    {
+        std::size_t page;
+        std::size_t slot;
+    };
+
+    struct Frame
+    {
+        std::vector<Entry> entries;
+    };
+
+    std::size_t page_len(std::size_t page) const
+    {
+        return std::min<std::size_t>(PAGE_SIZE, size_ - page * PAGE_SIZE);
+    }
+
+    AddrType page_addr(std::size_t page) const
+    {
+        return base_ + static_cast<AddrType>(page * PAGE_SIZE);
+    }
+
+    Frame& frame_at(std::size_t i)
+    {
+        return frames_[(head_ + i) % frames_.size()];
+    }
+
+    std::uint8_t* slot_data(std::size_t slot)
+    {
+        return pool_.data() + slot * PAGE_SIZE;
+    }
+
+    std::size_t acquire()
+    {
+        if(free_slots_.empty())
+        {
+            free_slots_.push_back(pool_.size() / PAGE_SIZE);
+            pool_.resize(pool_.size() + PAGE_SIZE);
+            ++stats_.pool_pages;
+        }
+
+        auto slot{free_slots_.back()};
+        free_slots_.pop_back();
+        return slot;
+    }
+
+    void release(Frame& frame)
+    {
+        for(const auto& entry : frame.entries)
+            free_slots_.push_back(entry.slot);
+        frame.entries.clear();
+    }
+
+    HandleType* mem_hdl_;
+    AddrType base_;
+    USizeType size_;
+
+    std::vector<Frame> frames_;
+    std::size_t head_{};
+    std::size_t count_{};
+    bool initialized_{};
+
+    std::vector<std::uint8_t> shadow_;
+    std::vector<std::uint8_t> pool_;
+    std::vector<std::size_t> free_slots_;
+
+    std::vector<std::size_t> page_src_;
+    std::vector<std::size_t> touched_;
+    std::vector<std::uint8_t> scratch_;
+    Stats stats_;
+};
+
+} // Mem64
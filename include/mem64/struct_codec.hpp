@@ -0,0 +1,283 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#include "handle_traits.hpp"
+#include "reference_wrapper.hpp"
+
+
+namespace Mem64
+{
+
+enum class FieldEncoding : std::uint8_t
+{
+    DELTA, ///< Zigzag varint of the difference to the previous frame
+    XOR    ///< Varint of the changed bits, floats without quantum always use this
+};
+
+/// Encodes registered fields of a guest struct against the previous frame
+///
+/// The struct is read with one read_raw, unchanged fields cost a single bit. Sender and receiver each
+/// keep their own StructCodec and have to start from the same state, i.e. both freshly constructed or reset().
+/// The first frame after that is a keyframe which sends every field, so the receiver's guest memory does
+/// not have to match the sender's beforehand.
+template<typename TStruct, typename THandle>
+struct StructCodec
+{
+    using HandleType = THandle;
+    using AddrType = typename HandleType::addr_t;
+    using USizeType = typename HandleType::usize_t;
+    using RefType = Ref<TStruct, HandleType>;
+
+    /// Register a field, float fields with a quantum > 0 are rounded to multiples of it
+    template<typename TMember>
+    StructCodec& add_field(TMember TStruct::* member, FieldEncoding encoding = FieldEncoding::DELTA,
+                           double quantum = 0.0)
+    {
+        static_assert(std::is_fundamental_v<TMember> || std::is_enum_v<TMember>);
+        static_assert(sizeof(TMember) <= 8);
+
+        Field field;
+        field.offset = offset_of<std::size_t>(member);
+        field.size = sizeof(TMember);
+        field.quantum = quantum;
+        field.encoding = encoding;
+        field.load = &load_field<TMember>;
+        field.store = &store_field<TMember>;
+
+        if constexpr(std::is_floating_point_v<TMember>)
+        {
+            if(quantum <= 0.0)
+                field.encoding = FieldEncoding::XOR;
+        }
+
+        fields_.push_back(field);
+        prev_.push_back(0);
+        return *this;
+    }
+
+    /// Append the encoded frame of the struct behind ref to out
+    void encode(const RefType& ref, std::vector<std::uint8_t>& out)
+    {
+        raw_.resize(sizeof(TStruct));
+        ref.hdl().read_raw(ref.offset(), raw_.data(), static_cast<USizeType>(raw_.size()));
+        bool swap{raw_bytes_swapped(ref.hdl())};
+
+        auto start{out.size()};
+        auto mask_pos{out.size()};
+        out.resize(out.size() + mask_bytes(), 0);
+
+        for(std::size_t i{}; i < fields_.size(); ++i)
+        {
+            const auto& field{fields_[i]};
+            auto word{field.load(raw_.data() + field.offset, field.quantum, swap)};
+
+            if(!keyframe_ && word == prev_[i])
+                continue;
+
+            out[mask_pos + i / 8] |= static_cast<std::uint8_t>(1u << (i % 8));
+
+            if(field.encoding == FieldEncoding::XOR)
+                put_varint(out, word ^ prev_[i]);
+            else
+                put_varint(out, zigzag(static_cast<std::int64_t>(word - prev_[i])));
+
+            prev_[i] = word;
+        }
+
+        keyframe_ = false;
+        last_frame_bytes_ = out.size() - start;
+    }
+
+    /// Apply a frame produced by encode and write the changed fields through ref
+    ///
+    /// Returns the number of bytes consumed, 0 if the frame is truncated. A truncated frame changes
+    /// neither the codec state nor guest memory, so it can be retried once complete. Adjacent changed
+    /// fields are written with one write_raw.
+    std::size_t decode(const std::uint8_t* data, std::size_t n, const RefType& ref)
+    {
+        if(n < mask_bytes())
+            return 0;
+
+        changed_.clear();
+        words_.resize(fields_.size());
+
+        // Parse the whole frame before touching any state
+        std::size_t pos{mask_bytes()};
+        for(std::size_t i{}; i < fields_.size(); ++i)
+        {
+            if(!((data[i / 8] >> (i % 8)) & 1u))
+                continue;
+
+            if(!get_varint(data, n, pos, words_[i]))
+                return 0;
+            changed_.push_back(i);
+        }
+
+        raw_.resize(sizeof(TStruct));
+        bool swap{raw_bytes_swapped(ref.hdl())};
+
+        for(auto i : changed_)
+        {
+            auto v{words_[i]};
+            auto word{fields_[i].encoding == FieldEncoding::XOR ? prev_[i] ^ v
+                                                                 : prev_[i] + static_cast<std::uint64_t>(unzigzag(v))};
+            fields_[i].store(word, raw_.data() + fields_[i].offset, fields_[i].quantum, swap);
+            prev_[i] = word;
+        }
+
+        // Fields are registered in any order, write back in address order
+        std::sort(changed_.begin(), changed_.end(), [this](auto a, auto b){ return fields_[a].offset < fields_[b].offset; });
+
+        for(std::size_t first{}; first < changed_.size();)
+        {
+            auto begin{fields_[changed_[first]].offset},
+                 end{begin + fields_[changed_[first]].size};
+
+            auto last{first + 1};
+            for(; last < changed_.size() && fields_[changed_[last]].offset == end; ++last)
+                end += fields_[changed_[last]].size;
+
+            ref.hdl().write_raw(ref.offset() + static_cast<AddrType>(begin), raw_.data() + begin,
+                                static_cast<USizeType>(end - begin));
+            first = last;
+        }
+
+        last_frame_bytes_ = pos;
+        return pos;
+    }
+
+    /// Forget the previous frame, the next frame encodes every field in full
+    void reset()
+    {
+        std::fill(prev_.begin(), prev_.end(), 0);
+        keyframe_ = true;
+    }
+
+    /// Size of the last encoded or decoded frame
+    std::size_t last_frame_bytes() const
+    {
+        return last_frame_bytes_;
+    }
+
+    std::size_t field_count() const
+    {
+        return fields_.size();
+    }
+
+private:
+    struct Field
+    {
+        std::size_t offset;
+        std::size_t size;
+        double quantum;
+        FieldEncoding encoding;
+        std::uint64_t (*load)(const std::uint8_t*, double, bool);
+        void (*store)(std::uint64_t, std::uint8_t*, double, bool);
+    };
+
+    /// Map a field value to the 64 bit word that is diffed
+    template<typename T>
+    static std::uint64_t load_field(const std::uint8_t* data, double quantum, bool swap)
+    {
+        auto val{decode_raw<T>(data, swap)};
+
+        if constexpr(std::is_floating_point_v<T>)
+        {
+            if(quantum > 0.0)
+                return static_cast<std::uint64_t>(std::llround(val / quantum));
+
+            std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t> bits;
+            std::memcpy(&bits, &val, sizeof(T));
+            return bits;
+        }
+        else if constexpr(std::is_enum_v<T>)
+        {
+            return static_cast<std::uint64_t>(static_cast<std::underlying_type_t<T>>(val));
+        }
+        else
+        {
+            return static_cast<std::uint64_t>(val);
+        }
+    }
+
+    template<typename T>
+    static void store_field(std::uint64_t word, std::uint8_t* data, double quantum, bool swap)
+    {
+        T val;
+
+        if constexpr(std::is_floating_point_v<T>)
+        {
+            if(quantum > 0.0)
+            {
+                val = static_cast<T>(static_cast<double>(static_cast<std::int64_t>(word)) * quantum);
+            }
+            else
+            {
+                std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t> bits{
+                    static_cast<decltype(bits)>(word)};
+                std::memcpy(&val, &bits, sizeof(T));
+            }
+        }
+        else if constexpr(std::is_enum_v<T>)
+        {
+            val = static_cast<T>(static_cast<std::underlying_type_t<T>>(word));
+        }
+        else
+        {
+            val = static_cast<T>(word);
+        }
+
+        encode_raw<T>(val, data, swap);
+    }
+
+    std::size_t mask_bytes() const
+    {
+        return (fields_.size() + 7) / 8;
+    }
+
+    static std::uint64_t zigzag(std::int64_t v)
+    {
+        return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+    }
+
+    static std::int64_t unzigzag(std::uint64_t v)
+    {
+        return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+    }
+
+    static void put_varint(std::vector<std::uint8_t>& out, std::uint64_t v)
+    {
+        for(; v >= 0x80; v >>= 7)
+            out.push_back(static_cast<std::uint8_t>(v) | 0x80);
+        out.push_back(static_cast<std::uint8_t>(v));
+    }
+
+    static bool get_varint(const std::uint8_t* data, std::size_t n, std::size_t& pos, std::uint64_t& v)
+    {
+        v = 0;
+        for(int shift = 0; pos < n && shift < 64; shift += 7)
+        {
+            auto b{data[pos++]};
+            v |= static_cast<std::uint64_t>(b & 0x7F) << shift;
+            if(!(b & 0x80))
+                return true;
+        }
+        return false;
+    }
+
+    std::vector<Field> fields_;
+    std::vector<std::uint64_t> prev_;
+    std::vector<std::uint8_t> raw_;
+    std::vector<std::size_t> changed_;
+    std::vector<std::uint64_t> words_;
+    std::size_t last_frame_bytes_{};
+    bool keyframe_{true};
+};
+
+} // Mem64
@@ -25,14 +25,14 @@ struct Ref<TType, THandle,
                           std::add_const_t<T>,
                       T>;
 
-    explicit Ref(const HandleType& hdl, AddrType addr = HandleType::INVALID_OFFSET):
+    explicit Ref(HandleType& hdl, AddrType addr = HandleType::INVALID_OFFSET):
     RefBase<Ref<TType, THandle>>(hdl, addr)
     {}
 
     template<typename TMember>
     const auto field(TMember (RawType::*const member)) const
     {
-        return Ref<Qualified<TMember>, HandleType>(this->mem_hdl_, this->addr_ + offset_of<USizeType>(member));
+        return Ref<Qualified<TMember>, HandleType>(*this->mem_hdl_, this->addr_ + offset_of<USizeType>(member));
     }
 };
 
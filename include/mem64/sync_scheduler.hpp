@@ -0,0 +1,238 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+
+namespace Mem64
+{
+
+/// Runs the per frame sync of many emulator sessions on a fixed pool of threads
+///
+/// Every tick each session's read job and then its write job run back to back on one worker, so all
+/// handle operations of a session are batched into one task. Sessions are queued on a home worker
+/// for cache affinity, idle workers steal from the back of other queues.
+/// Sessions must only be added and latencies only be queried between ticks.
+struct SyncScheduler
+{
+    using SessionId = std::size_t;
+    using Job = std::function<void()>;
+
+    /// Number of recent ticks latency percentiles are computed over
+    static constexpr std::size_t LATENCY_SAMPLES{256};
+
+    struct TickLatency
+    {
+        std::chrono::nanoseconds p50{};
+        std::chrono::nanoseconds p90{};
+        std::chrono::nanoseconds p99{};
+        std::chrono::nanoseconds max{};
+    };
+
+
+    explicit SyncScheduler(unsigned threads = std::thread::hardware_concurrency())
+    {
+        threads = std::max(threads, 1u);
+
+        for(unsigned i{}; i < threads; ++i)
+            workers_.push_back(std::make_unique<Worker>());
+
+        for(unsigned i{}; i < threads; ++i)
+            threads_.emplace_back([this, i]{ run(i); });
+    }
+
+    SyncScheduler(const SyncScheduler&) = delete;
+    SyncScheduler& operator=(const SyncScheduler&) = delete;
+
+    ~SyncScheduler()
+    {
+        {
+            std::lock_guard lock{mtx_};
+            stop_ = true;
+        }
+        work_cv_.notify_all();
+
+        for(auto& t : threads_)
+            t.join();
+    }
+
+    SessionId add_session(Job read_job, Job write_job)
+    {
+        auto session{std::make_unique<Session>()};
+        session->read_job = std::move(read_job);
+        session->write_job = std::move(write_job);
+        sessions_.push_back(std::move(session));
+        return sessions_.size() - 1;
+    }
+
+    /// Run one sync of every session and wait for all of them, rethrows the first job exception
+    void tick()
+    {
+        if(sessions_.empty())
+            return;
+
+        tick_start_ = std::chrono::steady_clock::now();
+
+        // Workers still leaving the previous tick may pick up sessions before they are woken
+        {
+            std::lock_guard lock{mtx_};
+            pending_ = sessions_.size();
+        }
+
+        for(SessionId id{}; id < sessions_.size(); ++id)
+        {
+            auto& worker{*workers_[id % workers_.size()]};
+            std::lock_guard lock{worker.mtx};
+            worker.queue.push_back(id);
+        }
+
+        std::unique_lock lock{mtx_};
+        ++generation_;
+        work_cv_.notify_all();
+        done_cv_.wait(lock, [this]{ return pending_ == 0; });
+
+        if(error_)
+            std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+
+    /// Latency from tick start to completion of the session over the last LATENCY_SAMPLES ticks
+    TickLatency latency(SessionId id) const
+    {
+        const auto& session{*sessions_[id]};
+        auto count{std::min(session.samples_taken, LATENCY_SAMPLES)};
+        if(count == 0)
+            return {};
+
+        std::vector<std::int64_t> sorted(session.samples.begin(), session.samples.begin() + count);
+        std::sort(sorted.begin(), sorted.end());
+
+        auto at{[&](double p){ return std::chrono::nanoseconds{sorted[static_cast<std::size_t>(p * (count - 1))]}; }};
+        return {at(0.5), at(0.9), at(0.99), std::chrono::nanoseconds{sorted.back()}};
+    }
+
+    std::size_t session_count() const
+    {
+        return sessions_.size();
+    }
+
+    std::size_t thread_count() const
+    {
+        return threads_.size();
+    }
+
+private:
+    struct Session
+    {
+        Job read_job;
+        Job write_job;
+        std::array<std::int64_t, LATENCY_SAMPLES> samples{};
+        std::size_t samples_taken{};
+    };
+
+    struct Worker
+    {
+        std::mutex mtx;
+        std::deque<SessionId> queue;
+    };
+
+    bool pop(std::size_t self, SessionId& id)
+    {
+        for(std::size_t i{}; i < workers_.size(); ++i)
+        {
+            auto& worker{*workers_[(self + i) % workers_.size()]};
+            std::lock_guard lock{worker.mtx};
+
+            if(worker.queue.empty())
+                continue;
+
+            // Own queue from the front, victims from the back
+            if(i == 0)
+            {
+                id = worker.queue.front();
+                worker.queue.pop_front();
+            }
+            else
+            {
+                id = worker.queue.back();
+                worker.queue.pop_back();
+            }
+            return true;
+        }
+
+        return false;
+    }
+
+    void execute(SessionId id)
+    {
+        auto& session{*sessions_[id]};
+        std::exception_ptr error;
+
+        try
+        {
+            if(session.read_job)
+                session.read_job();
+            if(session.write_job)
+                session.write_job();
+        }
+        catch(...)
+        {
+            error = std::current_exception();
+        }
+
+        auto elapsed{std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - tick_start_)};
+        session.samples[session.samples_taken++ % LATENCY_SAMPLES] = elapsed.count();
+
+        std::lock_guard lock{mtx_};
+        if(error && !error_)
+            error_ = error;
+        if(--pending_ == 0)
+            done_cv_.notify_all();
+    }
+
+    void run(std::size_t self)
+    {
+        std::uint64_t seen{};
+
+        for(;;)
+        {
+            {
+                std::unique_lock lock{mtx_};
+                work_cv_.wait(lock, [&]{ return stop_ || generation_ != seen; });
+                if(stop_)
+                    return;
+                seen = generation_;
+            }
+
+            SessionId id;
+            while(pop(self, id))
+                execute(id);
+        }
+    }
+
+    std::vector<std::unique_ptr<Session>> sessions_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::thread> threads_;
+
+    std::mutex mtx_;
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+    std::uint64_t generation_{};
+    std::size_t pending_{};
+    bool stop_{};
+    std::exception_ptr error_;
+    std::chrono::steady_clock::time_point tick_start_;
+};
+
+} // Mem64
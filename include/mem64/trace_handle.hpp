@@ -0,0 +1,391 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "handle_traits.hpp"
+
+
+namespace Mem64
+{
+
+enum class TraceOp : std::uint8_t
+{
+    READ,
+    WRITE,
+    READ_RAW,
+    WRITE_RAW
+};
+
+struct TraceEvent
+{
+    TraceOp op;
+    std::uint64_t addr;
+    std::uint64_t timestamp_ns; ///< Time since the log was started
+    const std::uint8_t* data;   ///< Null for reads if the log does not capture read data
+    std::size_t size;
+};
+
+/// Compact binary log of handle accesses
+///
+/// Every event is stored as op, timestamp delta, address delta to the end of the previous access and size,
+/// all as varints, followed by the data. Not thread safe, use one log per thread.
+struct TraceLog
+{
+    explicit TraceLog(bool capture_reads = true):
+        capture_reads_{capture_reads}, start_{std::chrono::steady_clock::now()}
+    {}
+
+    void record(TraceOp op, std::uint64_t addr, const std::uint8_t* data, std::size_t n)
+    {
+        auto now{static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     std::chrono::steady_clock::now() - start_).count())};
+        bool has_data{capture_reads_ || op == TraceOp::WRITE || op == TraceOp::WRITE_RAW};
+
+        buf_.push_back(static_cast<std::uint8_t>(op) | (has_data ? DATA_FLAG : 0));
+        put_varint(now - last_time_);
+        put_varint(zigzag(static_cast<std::int64_t>(addr - last_end_)));
+        put_varint(n);
+        if(has_data)
+            buf_.insert(buf_.end(), data, data + n);
+
+        last_time_ = now;
+        last_end_ = addr + n;
+        ++count_;
+    }
+
+    /// Decode the event at pos and advance pos, returns false at the end of the log or on a malformed event
+    bool next(std::size_t& pos, TraceEvent& ev, std::uint64_t& time, std::uint64_t& end) const
+    {
+        return decode(buf_, pos, ev, time, end);
+    }
+
+    /// Call fn for every event in recording order
+    template<typename TFn>
+    void for_each(TFn&& fn) const
+    {
+        TraceEvent ev{};
+        std::size_t pos{};
+        std::uint64_t time{}, end{};
+
+        while(next(pos, ev, time, end))
+            fn(static_cast<const TraceEvent&>(ev));
+    }
+
+    void save(std::ostream& os) const
+    {
+        std::uint64_t header[]{MAGIC, count_, buf_.size()};
+        os.write(reinterpret_cast<const char*>(header), sizeof(header));
+        os.write(reinterpret_cast<const char*>(buf_.data()), static_cast<std::streamsize>(buf_.size()));
+    }
+
+    /// Replace the log with one previously written by save
+    ///
+    /// Every event is validated before the log is replaced, on failure the log is left untouched and false
+    /// is returned. Recording continues after the last loaded event.
+    bool load(std::istream& is)
+    {
+        std::uint64_t header[3]{};
+        if(!is.read(reinterpret_cast<char*>(header), sizeof(header)) || header[0] != MAGIC)
+            return false;
+
+        // Grow with the data actually read so a corrupt size cannot trigger a huge allocation
+        std::vector<std::uint8_t> buf;
+        constexpr std::size_t READ_BLOCK{64 * 1024};
+
+        while(buf.size() < header[2])
+        {
+            auto pos{buf.size()};
+            auto len{static_cast<std::size_t>(std::min<std::uint64_t>(READ_BLOCK, header[2] - pos))};
+            buf.resize(pos + len);
+            if(!is.read(reinterpret_cast<char*>(buf.data() + pos), static_cast<std::streamsize>(len)))
+                return false;
+        }
+
+        TraceEvent ev{};
+        std::size_t pos{};
+        std::uint64_t count{}, time{}, end{};
+
+        for(; pos < buf.size(); ++count)
+        {
+            if(!decode(buf, pos, ev, time, end))
+                return false;
+        }
+
+        if(count != header[1])
+            return false;
+
+        buf_ = std::move(buf);
+        count_ = count;
+        last_time_ = time;
+        last_end_ = end;
+        // Timestamps of new events continue after the last loaded one
+        start_ = std::chrono::steady_clock::now() -
+                 std::chrono::nanoseconds{static_cast<std::chrono::nanoseconds::rep>(time)};
+        return true;
+    }
+
+    void clear()
+    {
+        buf_.clear();
+        count_ = last_time_ = last_end_ = 0;
+        start_ = std::chrono::steady_clock::now();
+    }
+
+    std::uint64_t event_count() const
+    {
+        return count_;
+    }
+
+    std::size_t byte_size() const
+    {
+        return buf_.size();
+    }
+
+private:
+    static constexpr std::uint64_t MAGIC{0x31454341'52543436ull}; // "64TRACE1"
+    static constexpr std::uint8_t DATA_FLAG{0x80};
+
+    static std::uint64_t zigzag(std::int64_t v)
+    {
+        return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+    }
+
+    static std::int64_t unzigzag(std::uint64_t v)
+    {
+        return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+    }
+
+    void put_varint(std::uint64_t v)
+    {
+        for(; v >= 0x80; v >>= 7)
+            buf_.push_back(static_cast<std::uint8_t>(v) | 0x80);
+        buf_.push_back(static_cast<std::uint8_t>(v));
+    }
+
+    static bool get_varint(const std::vector<std::uint8_t>& buf, std::size_t& pos, std::uint64_t& v)
+    {
+        v = 0;
+        for(int shift = 0; pos < buf.size() && shift < 64; shift += 7)
+        {
+            auto b{buf[pos++]};
+            v |= static_cast<std::uint64_t>(b & 0x7F) << shift;
+            if(!(b & 0x80))
+                return true;
+        }
+        return false;
+    }
+
+    static bool decode(const std::vector<std::uint8_t>& buf, std::size_t& pos, TraceEvent& ev,
+                       std::uint64_t& time, std::uint64_t& end)
+    {
+        if(pos >= buf.size())
+            return false;
+
+        auto tag{buf[pos++]};
+        if((tag & ~DATA_FLAG) > static_cast<std::uint8_t>(TraceOp::WRITE_RAW))
+            return false;
+
+        std::uint64_t dt, addr_delta, size;
+        if(!get_varint(buf, pos, dt) || !get_varint(buf, pos, addr_delta) || !get_varint(buf, pos, size))
+            return false;
+
+        auto op{static_cast<TraceOp>(tag & ~DATA_FLAG)};
+        bool has_data{(tag & DATA_FLAG) != 0};
+
+        // Writes always carry their data
+        if(has_data ? size > buf.size() - pos : (op == TraceOp::WRITE || op == TraceOp::WRITE_RAW))
+            return false;
+
+        ev.op = op;
+        time += dt;
+        ev.timestamp_ns = time;
+        ev.addr = end + static_cast<std::uint64_t>(unzigzag(addr_delta));
+        ev.size = static_cast<std::size_t>(size);
+        ev.data = has_data ? buf.data() + pos : nullptr;
+        if(has_data)
+            pos += ev.size;
+
+        end = ev.addr + ev.size;
+        return true;
+    }
+
+    bool capture_reads_;
+    std::chrono::steady_clock::time_point start_;
+    std::vector<std::uint8_t> buf_;
+    std::uint64_t count_{};
+    std::uint64_t last_time_{};
+    std::uint64_t last_end_{};
+};
+
+/// Handle decorator recording every access of the wrapped handle into a TraceLog
+///
+/// Deliberately does not forward host_ptr, direct access would bypass the trace.
+template<typename THandle>
+struct TraceHandle
+{
+    using addr_t = typename THandle::addr_t;
+    using saddr_t = typename THandle::saddr_t;
+    using usize_t = typename THandle::usize_t;
+    using ssize_t = typename THandle::ssize_t;
+
+    static constexpr addr_t INVALID_OFFSET{THandle::INVALID_OFFSET};
+    static constexpr bool SWAP_BYTES{hdl_swaps_bytes_v<THandle>};
+
+    TraceHandle(THandle hdl, TraceLog& log):
+        hdl_{std::move(hdl)}, log_{&log}
+    {}
+
+    bool swaps_bytes() const
+    {
+        return raw_bytes_swapped(hdl_);
+    }
+
+    void read_raw(addr_t offset, std::uint8_t data[], usize_t n)
+    {
+        hdl_.read_raw(offset, data, n);
+        log_->record(TraceOp::READ_RAW, offset, data, n);
+    }
+
+    void write_raw(addr_t offset, const std::uint8_t data[], usize_t n)
+    {
+        hdl_.write_raw(offset, data, n);
+        log_->record(TraceOp::WRITE_RAW, offset, data, n);
+    }
+
+    template<typename T>
+    T read(addr_t offset)
+    {
+        T val{hdl_.template read<T>(offset)};
+        log_->record(TraceOp::READ, offset, reinterpret_cast<const std::uint8_t*>(&val), sizeof(T));
+        return val;
+    }
+
+    template<typename T>
+    void write(addr_t offset, T val)
+    {
+        hdl_.template write<T>(offset, val);
+        log_->record(TraceOp::WRITE, offset, reinterpret_cast<const std::uint8_t*>(&val), sizeof(T));
+    }
+
+    template<typename T>
+    static bool valid_offset(addr_t offset)
+    {
+        return THandle::template valid_offset<T>(offset);
+    }
+
+    THandle& inner()
+    {
+        return hdl_;
+    }
+
+    TraceLog& log() const
+    {
+        return *log_;
+    }
+
+private:
+    THandle hdl_;
+    TraceLog* log_;
+};
+
+struct ReplayStats
+{
+    std::uint64_t ops{};
+    std::uint64_t bytes_read{};
+    std::uint64_t bytes_written{};
+    std::uint64_t read_checksum{}; ///< Checksum of all data read, equal for handles that saw the same memory
+    std::chrono::nanoseconds elapsed{};
+
+    double ops_per_sec() const
+    {
+        return elapsed.count() ? ops * 1e9 / static_cast<double>(elapsed.count()) : 0.0;
+    }
+
+    double bytes_per_sec() const
+    {
+        return elapsed.count() ? (bytes_read + bytes_written) * 1e9 / static_cast<double>(elapsed.count()) : 0.0;
+    }
+};
+
+namespace detail
+{
+
+template<typename TUInt, typename THandle>
+void replay_scalar(THandle& hdl, const TraceEvent& ev, ReplayStats& stats)
+{
+    auto addr{static_cast<typename THandle::addr_t>(ev.addr)};
+
+    if(ev.op == TraceOp::READ)
+    {
+        stats.read_checksum += static_cast<std::uint64_t>(hdl.template read<TUInt>(addr));
+    }
+    else
+    {
+        TUInt val;
+        std::memcpy(&val, ev.data, sizeof(val));
+        hdl.template write<TUInt>(addr, val);
+    }
+}
+
+} // detail
+
+/// Re-execute every access of log against hdl as fast as possible
+///
+/// Scalar accesses are replayed as unsigned integers of the recorded size.
+template<typename THandle>
+ReplayStats replay(const TraceLog& log, THandle& hdl)
+{
+    using AddrType = typename THandle::addr_t;
+    using USizeType = typename THandle::usize_t;
+
+    ReplayStats stats;
+    std::vector<std::uint8_t> scratch;
+    auto start{std::chrono::steady_clock::now()};
+
+    log.for_each([&](const TraceEvent& ev)
+    {
+        auto addr{static_cast<AddrType>(ev.addr)};
+
+        switch(ev.op)
+        {
+        case TraceOp::READ_RAW:
+            scratch.resize(ev.size);
+            hdl.read_raw(addr, scratch.data(), static_cast<USizeType>(ev.size));
+            for(auto b : scratch)
+                stats.read_checksum += b;
+            stats.bytes_read += ev.size;
+            break;
+        case TraceOp::WRITE_RAW:
+            hdl.write_raw(addr, ev.data, static_cast<USizeType>(ev.size));
+            stats.bytes_written += ev.size;
+            break;
+        case TraceOp::READ:
+        case TraceOp::WRITE:
+            switch(ev.size)
+            {
+            case 1: detail::replay_scalar<std::uint8_t>(hdl, ev, stats); break;
+            case 2: detail::replay_scalar<std::uint16_t>(hdl, ev, stats); break;
+            case 4: detail::replay_scalar<std::uint32_t>(hdl, ev, stats); break;
+            case 8: detail::replay_scalar<std::uint64_t>(hdl, ev, stats); break;
+            default: break;
+            }
+            (ev.op == TraceOp::READ ? stats.bytes_read : stats.bytes_written) += ev.size;
+            break;
+        }
+
+        ++stats.ops;
+    });
+
+    stats.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    return stats;
+}
+
+} // Mem64
@@ -0,0 +1,236 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "handle_traits.hpp"
+#include "reference_wrapper.hpp"
+
+
+namespace Mem64
+{
+
+/// Polls many watched values at once and fires callbacks for the ones that changed
+///
+/// Watched addresses are sorted and coalesced into as few read_raw calls as possible. Each poll compares
+/// the new snapshot against the previous one in BLOCK_SIZE blocks and only inspects the watches of blocks
+/// that changed, so poll cost follows the bytes read rather than the number of watches.
+template<typename THandle>
+struct WatchList
+{
+    using HandleType = THandle;
+    using AddrType = typename HandleType::addr_t;
+    using USizeType = typename HandleType::usize_t;
+    using WatchId = std::size_t;
+
+    /// Watches closer than this are fetched by the same read_raw
+    static constexpr USizeType MAX_GAP{64};
+
+    /// Granularity of the snapshot comparison
+    static constexpr std::size_t BLOCK_SIZE{64};
+
+
+    explicit WatchList(HandleType& hdl):
+        mem_hdl_{&hdl}
+    {}
+
+    /// Call callback(new_value, old_value) whenever the value behind ref changes
+    ///
+    /// The first poll after a watch is added records its value without firing. ref has to be bound to
+    /// the handle of the list, throws std::invalid_argument otherwise.
+    template<typename T, typename TFn>
+    WatchId watch(const Ref<T, HandleType>& ref, TFn&& callback)
+    {
+        using RawType = std::remove_cv_t<T>;
+        static_assert(std::is_fundamental_v<RawType> || std::is_enum_v<RawType>);
+        static_assert(sizeof(RawType) <= 8, "watched values are kept in 8 byte slots");
+
+        if(&ref.hdl() != mem_hdl_)
+            throw std::invalid_argument{"watched Ref is bound to another handle"};
+
+        Watch w;
+        w.addr = ref.offset();
+        w.size = sizeof(RawType);
+        w.fire = [fn = std::forward<TFn>(callback), hdl = mem_hdl_](const std::uint8_t* cur, const std::uint8_t* prev)
+        {
+            fn(hdl_decode<RawType>(*hdl, cur), hdl_decode<RawType>(*hdl, prev));
+        };
+
+        watches_.push_back(std::move(w));
+        layout_dirty_ = true;
+        return watches_.size() - 1;
+    }
+
+    /// Read all watched values and fire the callbacks of changed ones
+    void poll()
+    {
+        if(layout_dirty_)
+            rebuild();
+
+        for(const auto& range : ranges_)
+            mem_hdl_->read_raw(range.addr, cur_.data() + range.buf_offset, static_cast<USizeType>(range.size));
+
+        changed_.clear();
+
+        if(baseline_)
+        {
+            for(WatchId id{}; id < watches_.size(); ++id)
+                check(id);
+            baseline_ = false;
+        }
+        else
+        {
+            auto blocks{block_start_.size() - 1};
+            for(std::size_t block{}; block < blocks; ++block)
+            {
+                auto begin{block * BLOCK_SIZE},
+                     len{std::min(BLOCK_SIZE, cur_.size() - begin)};
+
+                if(std::memcmp(cur_.data() + begin, prev_.data() + begin, len) == 0)
+                    continue;
+
+                for(auto i{block_start_[block]}; i < block_start_[block + 1]; ++i)
+                    check(block_watches_[i]);
+            }
+        }
+
+        std::swap(cur_, prev_);
+
+        // Fire after comparing so callbacks may add watches safely
+        for(const auto& [id, old] : changed_)
+            watches_[id].fire(watches_[id].last, old);
+    }
+
+    std::size_t size() const
+    {
+        return watches_.size();
+    }
+
+    /// Number of read_raw calls a poll makes
+    std::size_t read_count() const
+    {
+        return ranges_.size();
+    }
+
+    void clear()
+    {
+        watches_.clear();
+        layout_dirty_ = true;
+    }
+
+private:
+    struct Watch
+    {
+        AddrType addr;
+        std::size_t size;
+        std::size_t buf_offset{};
+        bool initialized{};
+        std::uint8_t last[8]{};
+        std::function<void(const std::uint8_t*, const std::uint8_t*)> fire;
+    };
+
+    struct Range
+    {
+        AddrType addr;
+        std::size_t size;
+        std::size_t buf_offset;
+    };
+
+    struct Change
+    {
+        WatchId id;
+        std::uint8_t old[8];
+    };
+
+    void check(WatchId id)
+    {
+        auto& w{watches_[id]};
+        const auto* cur{cur_.data() + w.buf_offset};
+
+        if(w.initialized && std::memcmp(cur, w.last, w.size) == 0)
+            return;
+
+        if(w.initialized)
+        {
+            Change change{id, {}};
+            std::memcpy(change.old, w.last, w.size);
+            changed_.push_back(change);
+        }
+
+        std::memcpy(w.last, cur, w.size);
+        w.initialized = true;
+    }
+
+    void rebuild()
+    {
+        std::vector<WatchId> order(watches_.size());
+        std::iota(order.begin(), order.end(), WatchId{});
+        std::sort(order.begin(), order.end(), [this](auto a, auto b){ return watches_[a].addr < watches_[b].addr; });
+
+        ranges_.clear();
+        std::size_t buf_size{};
+
+        for(auto id : order)
+        {
+            auto& w{watches_[id]};
+            auto end{w.addr + static_cast<AddrType>(w.size)};
+
+            if(ranges_.empty() || w.addr > ranges_.back().addr + ranges_.back().size + MAX_GAP)
+            {
+                ranges_.push_back({w.addr, 0, buf_size});
+            }
+
+            auto& range{ranges_.back()};
+            auto new_size{std::max(range.size, static_cast<std::size_t>(end - range.addr))};
+            buf_size += new_size - range.size;
+            range.size = new_size;
+            w.buf_offset = range.buf_offset + static_cast<std::size_t>(w.addr - range.addr);
+        }
+
+        cur_.assign(buf_size, 0);
+        prev_.assign(buf_size, 0);
+
+        // Compressed block -> watches index
+        auto blocks{(buf_size + BLOCK_SIZE - 1) / BLOCK_SIZE};
+        block_start_.assign(blocks + 1, 0);
+
+        for(const auto& w : watches_)
+            for(auto b{w.buf_offset / BLOCK_SIZE}; b <= (w.buf_offset + w.size - 1) / BLOCK_SIZE; ++b)
+                ++block_start_[b + 1];
+
+        std::partial_sum(block_start_.begin(), block_start_.end(), block_start_.begin());
+        block_watches_.resize(block_start_.back());
+
+        auto fill{block_start_};
+        for(WatchId id{}; id < watches_.size(); ++id)
+        {
+            const auto& w{watches_[id]};
+            for(auto b{w.buf_offset / BLOCK_SIZE}; b <= (w.buf_offset + w.size - 1) / BLOCK_SIZE; ++b)
+                block_watches_[fill[b]++] = id;
+        }
+
+        layout_dirty_ = false;
+        baseline_ = true;
+    }
+
+    HandleType* mem_hdl_;
+    std::deque<Watch> watches_;
+    std::vector<Range> ranges_;
+    std::vector<std::uint8_t> cur_;
+    std::vector<std::uint8_t> prev_;
+    std::vector<std::size_t> block_start_{0};
+    std::vector<WatchId> block_watches_;
+    std::vector<Change> changed_;
+    bool layout_dirty_{};
+    bool baseline_{};
+};
+
+} // Mem64
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+
+namespace Mem64Test
+{
+
+inline std::atomic<std::size_t>& allocations()
+{
+    static std::atomic<std::size_t> count{};
+    return count;
+}
+
+} // Mem64Test
+
+// Replaces the global operator new to count allocations, include in exactly one file per test
+void* operator new(std::size_t n)
+{
+    ++Mem64Test::allocations();
+    if(void* p{std::malloc(n ? n : 1)})
+        return p;
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
@@ -0,0 +1,190 @@
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "mem64/allocator.hpp"
+#include "fake_handle.hpp"
+#include "test_util.hpp"
+
+using namespace Mem64;
+using namespace Mem64Test;
+
+
+static void test_size_classes()
+{
+    std::vector<std::uint8_t> mem(0x10000);
+    VecHandle hdl{mem};
+    GuestAllocator<VecHandle> alloc{hdl, 0x1000, 0x8000};
+
+    auto a{alloc.allocate<std::uint32_t>()};
+    auto b{alloc.allocate<std::uint64_t>()};
+    auto c{alloc.allocate_array<std::uint16_t>(20)};
+
+    MEM64_CHECK(a.valid() && b.valid() && c.valid());
+    MEM64_CHECK(a.offset() % 8 == 0 && b.offset() % 8 == 0 && c.offset() % 64 == 0);
+    MEM64_CHECK(a.offset() != b.offset());
+    MEM64_CHECK(alloc.bytes_used() == 8 + 8 + 64);
+
+    *a = 0x11223344u;
+    *b = 0x5566778899AABBCCull;
+    MEM64_CHECK((*a).read() == 0x11223344u);
+    MEM64_CHECK((*b).read() == 0x5566778899AABBCCull);
+
+    // Nothing but the writes above touched the handle
+    MEM64_CHECK(hdl.reads == 2 && hdl.writes == 2);
+
+    alloc.deallocate(a);
+    alloc.deallocate(b);
+    alloc.deallocate(c, 20);
+    MEM64_CHECK(alloc.bytes_used() == 0);
+
+    // Freed blocks are reused
+    MEM64_CHECK(alloc.allocate<std::uint64_t>().offset() == b.offset());
+}
+
+static void test_large_coalesce()
+{
+    std::vector<std::uint8_t> mem(0x10000);
+    VecHandle hdl{mem};
+    GuestAllocator<VecHandle> alloc{hdl, 0x100, 0x9000};
+
+    auto a{alloc.allocate_array<std::uint8_t>(0x3000)};
+    auto b{alloc.allocate_array<std::uint8_t>(0x3000)};
+    auto c{alloc.allocate_array<std::uint8_t>(0x3000)};
+    MEM64_CHECK(a.valid() && b.valid() && c.valid());
+    MEM64_CHECK(!alloc.allocate_array<std::uint8_t>(0x2000).valid());
+
+    alloc.deallocate(a, 0x3000);
+    alloc.deallocate(c, 0x3000);
+    MEM64_CHECK(!alloc.allocate_array<std::uint8_t>(0x4000).valid());
+
+    alloc.deallocate(b, 0x3000);
+    auto all{alloc.allocate_array<std::uint8_t>(0x9000)};
+    MEM64_CHECK(all.valid() && all.offset() == 0x100);
+}
+
+static void test_class_pages_return()
+{
+    std::vector<std::uint8_t> mem(0x10000);
+    VecHandle hdl{mem};
+    GuestAllocator<VecHandle> alloc{hdl, 0x1000, 60000};
+
+    // Fill the region with small blocks of several classes
+    std::vector<std::pair<GuestAllocator<VecHandle>::AddrType, std::uint32_t>> blocks;
+    for(std::uint32_t i{};; ++i)
+    {
+        auto size{8u << (i % 5)};
+        auto addr{alloc.allocate_raw(size, 1)};
+        if(addr == VecHandle::INVALID_OFFSET)
+            break;
+        blocks.emplace_back(addr, size);
+    }
+    MEM64_CHECK(blocks.size() > 100);
+    MEM64_CHECK(!alloc.allocate_array<std::uint8_t>(50000).valid());
+
+    for(auto [addr, size] : blocks)
+        alloc.deallocate_raw(addr, size, 1);
+
+    MEM64_CHECK(alloc.bytes_used() == 0);
+    MEM64_CHECK(alloc.allocate_array<std::uint8_t>(50000).valid());
+}
+
+static void test_trim_keeps_live_pages()
+{
+    std::vector<std::uint8_t> mem(0x10000);
+    VecHandle hdl{mem};
+    GuestAllocator<VecHandle> alloc{hdl, 0x1000, 0x4000};
+
+    std::vector<Ptr<std::uint64_t, VecHandle>> ptrs;
+    for(int i{}; i < 1024; ++i)
+        ptrs.push_back(alloc.allocate<std::uint64_t>());
+    MEM64_CHECK(std::all_of(ptrs.begin(), ptrs.end(), [](const auto& p){ return p.valid(); }));
+
+    // Free all but one block per page, no page can be returned
+    for(std::size_t i{}; i < ptrs.size(); ++i)
+        if(i % 512 != 7)
+            alloc.deallocate(ptrs[i]);
+
+    MEM64_CHECK(!alloc.trim());
+    MEM64_CHECK(!alloc.allocate_array<std::uint8_t>(0x3000).valid());
+
+    // Second page is adjacent to the free tail of the region once returned
+    alloc.deallocate(ptrs[519]);
+    MEM64_CHECK(alloc.allocate_array<std::uint8_t>(0x3000).valid());
+
+    // The remaining page still hands out its free blocks
+    auto p{alloc.allocate<std::uint64_t>()};
+    MEM64_CHECK(p.valid() && p.offset() / 0x1000 == ptrs[7].offset() / 0x1000);
+}
+
+static void test_pointer_alignment()
+{
+    std::vector<std::uint8_t> mem(0x10000);
+    VecHandle hdl{mem};
+    GuestAllocator<VecHandle> alloc{hdl, 0x1001, 0x8000};
+
+    auto ptrs{alloc.allocate_array<std::uint8_t*>(3)};
+    MEM64_CHECK(ptrs.valid() && ptrs.offset() % alignof(VecHandle::addr_t) == 0);
+    MEM64_CHECK(alloc.bytes_used() == 16);
+}
+
+static void test_small_regions()
+{
+    std::vector<std::uint8_t> mem(0x10000);
+    VecHandle hdl{mem};
+
+    // No aligned page fits, small requests are still served
+    GuestAllocator<VecHandle> unaligned{hdl, 0x8100, 0x800};
+    auto a{unaligned.allocate<std::uint32_t>()};
+    MEM64_CHECK(a.valid() && a.offset() >= 0x8100 && a.offset() < 0x8900);
+
+    // A single page is not given to a size class, the rest stays usable for large requests
+    GuestAllocator<VecHandle> one_page{hdl, 0x1000, 0x1000};
+    auto b{one_page.allocate<std::uint32_t>()};
+    auto c{one_page.allocate_raw(2000, 8)};
+    MEM64_CHECK(b.valid() && c != VecHandle::INVALID_OFFSET);
+    MEM64_CHECK(one_page.bytes_used() == 8 + 2000);
+
+    one_page.deallocate(b);
+    one_page.deallocate_raw(c, 2000, 8);
+    MEM64_CHECK(one_page.bytes_used() == 0);
+    MEM64_CHECK(one_page.allocate_raw(0x1000, 8) == 0x1000);
+}
+
+static void test_frame_arena()
+{
+    std::vector<std::uint8_t> mem(0x1000);
+    VecHandle hdl{mem};
+    FrameArena<VecHandle> arena{hdl, 0x101, 0x100};
+
+    auto a{arena.allocate<std::uint8_t>()};
+    auto b{arena.allocate<std::uint32_t>()};
+    MEM64_CHECK(a.offset() == 0x101 && b.offset() == 0x104);
+    MEM64_CHECK(arena.bytes_used() == 7);
+
+    MEM64_CHECK(arena.allocate_array<std::uint8_t>(0xF9).valid());
+    MEM64_CHECK(!arena.allocate<std::uint8_t>().valid());
+
+    arena.reset();
+    MEM64_CHECK(arena.bytes_used() == 0);
+    MEM64_CHECK(arena.allocate<std::uint32_t>().offset() == 0x104);
+
+    // Address 0 is never handed out, a failed request leaves the arena as it was
+    FrameArena<VecHandle> zero{hdl, 0, 0x10};
+    auto c{zero.allocate<std::uint8_t>()};
+    MEM64_CHECK(c.valid() && c.offset() == 1);
+    MEM64_CHECK(zero.bytes_used() == 2);
+    MEM64_CHECK(!zero.allocate_array<std::uint8_t>(0x20).valid());
+    MEM64_CHECK(zero.bytes_used() == 2);
+}
+
+int main()
+{
+    test_size_classes();
+    test_large_coalesce();
+    test_class_pages_return();
+    test_trim_keeps_live_pages();
+    test_pointer_alignment();
+    test_small_regions();
+    test_frame_arena();
+    return finish();
+}
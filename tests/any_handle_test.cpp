@@ -0,0 +1,122 @@
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "mem64/mem64.hpp"
+#include "mem64/any_handle.hpp"
+#include "mem64/trace_handle.hpp"
+#include "fake_handle.hpp"
+#include "test_util.hpp"
+
+using namespace Mem64;
+using namespace Mem64Test;
+
+
+static void test_region_end()
+{
+    std::vector<std::uint8_t> mem(100);
+    mem[99] = 0x5A;
+
+    // A scalar read at the end of the buffer must not fetch past it
+    AnyHandle hdl{VecHandle{mem}};
+    MEM64_CHECK(hdl.read<std::uint8_t>(99) == 0x5A);
+
+    hdl.enable_cache(0, 100);
+    MEM64_CHECK(hdl.read<std::uint8_t>(99) == 0x5A);
+    MEM64_CHECK(hdl.read<std::uint16_t>(96) == 0);
+    MEM64_CHECK_THROWS(hdl.read<std::uint8_t>(100), std::out_of_range);
+}
+
+static void test_cache_opt_in()
+{
+    std::vector<std::uint8_t> mem(0x1000);
+    AnyHandle hdl{VecHandle{mem}};
+    auto& backend{*hdl.get<VecHandle>()};
+
+    // Without a cache every read reaches the backend and sees guest changes
+    mem[0x10] = 1;
+    MEM64_CHECK(hdl.read<std::uint8_t>(0x10) == 1);
+    mem[0x10] = 2;
+    MEM64_CHECK(hdl.read<std::uint8_t>(0x10) == 2);
+    MEM64_CHECK(backend.reads == 2);
+
+    hdl.enable_cache(0x100, 0x200);
+    backend.reads.reset();
+    for(std::uint32_t i{}; i < 16; ++i)
+        hdl.read<std::uint32_t>(0x100 + i * 4);
+    MEM64_CHECK(backend.reads == 1);
+
+    // Outside of the region reads go direct
+    hdl.read<std::uint32_t>(0x10);
+    hdl.read<std::uint32_t>(0x300);
+    MEM64_CHECK(backend.reads == 3);
+
+    // Guest changes stay hidden until invalidated, own writes update the line
+    mem[0x104] = 7;
+    MEM64_CHECK(hdl.read<std::uint8_t>(0x104) == 0);
+    hdl.write<std::uint8_t>(0x108, 9);
+    MEM64_CHECK(hdl.read<std::uint8_t>(0x108) == 9 && mem[0x108] == 9);
+    hdl.invalidate_cache();
+    MEM64_CHECK(hdl.read<std::uint8_t>(0x104) == 7);
+
+    hdl.disable_cache();
+    mem[0x104] = 8;
+    MEM64_CHECK(hdl.read<std::uint8_t>(0x104) == 8);
+}
+
+static void test_unaligned_region()
+{
+    std::vector<std::uint8_t> mem(0x100);
+    for(std::size_t i{}; i < mem.size(); ++i)
+        mem[i] = static_cast<std::uint8_t>(i);
+
+    // Lines partially covered by the region only fetch the covered part
+    VecHandle inner{mem};
+    AnyHandle hdl{inner};
+    hdl.enable_cache(0x30, 0x20);
+
+    MEM64_CHECK(hdl.read<std::uint8_t>(0x30) == 0x30);
+    MEM64_CHECK(hdl.read<std::uint8_t>(0x4F) == 0x4F);
+    MEM64_CHECK(hdl.read<std::uint8_t>(0x2F) == 0x2F);
+    MEM64_CHECK(hdl.read<std::uint8_t>(0x50) == 0x50);
+}
+
+static void test_byte_order()
+{
+    std::vector<std::uint8_t> mem(0x100);
+    mem[0x20] = 0x11;
+    mem[0x23] = 0x44;
+
+    AnyHandle any{SwapVecHandle{mem}};
+    MEM64_CHECK(any.swaps_bytes());
+    MEM64_CHECK(any.read<std::uint32_t>(0x20) == 0x11000044u);
+
+    // The decorator keeps the byte order of the handle it wraps
+    TraceLog log;
+    TraceHandle<SwapVecHandle> traced{SwapVecHandle{mem}, log};
+    static_assert(hdl_swaps_bytes_v<TraceHandle<SwapVecHandle>>);
+    static_assert(!hdl_swaps_bytes_v<TraceHandle<VecHandle>>);
+
+    std::uint8_t raw[4];
+    traced.read_raw(0x20, raw, sizeof(raw));
+    MEM64_CHECK(hdl_decode<std::uint32_t>(traced, raw) == traced.read<std::uint32_t>(0x20));
+
+    // Runtime byte order of a type erased handle survives further wrapping
+    AnyHandle any_traced{TraceHandle<SwapVecHandle>{SwapVecHandle{mem}, log}};
+    TraceHandle<AnyHandle> outer{AnyHandle{SwapVecHandle{mem}}, log};
+    MEM64_CHECK(any_traced.swaps_bytes() && outer.swaps_bytes());
+    MEM64_CHECK(hdl_decode<std::uint32_t>(any, raw) == 0x11000044u);
+    MEM64_CHECK(hdl_decode<std::uint32_t>(outer, raw) == 0x11000044u);
+
+    std::uint8_t out[4];
+    hdl_encode<std::uint32_t>(any_traced, 0x11000044u, out);
+    MEM64_CHECK(out[0] == 0x11 && out[3] == 0x44);
+}
+
+int main()
+{
+    test_region_end();
+    test_cache_opt_in();
+    test_unaligned_region();
+    test_byte_order();
+    return finish();
+}
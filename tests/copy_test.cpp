@@ -0,0 +1,120 @@
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+#include "mem64/copy.hpp"
+#include "fake_handle.hpp"
+#include "test_util.hpp"
+
+using namespace Mem64;
+using namespace Mem64Test;
+
+
+static std::vector<std::uint8_t> pattern(std::size_t n)
+{
+    std::vector<std::uint8_t> mem(n);
+    std::iota(mem.begin(), mem.end(), std::uint8_t{1});
+    return mem;
+}
+
+static void test_direct_to_direct()
+{
+    auto src_mem{pattern(1000)};
+    std::vector<std::uint8_t> dst_mem(1000);
+    DirectVecHandle src{src_mem}, dst{dst_mem};
+
+    copy(src, 100, dst, 200, 700);
+
+    MEM64_CHECK(std::equal(src_mem.begin() + 100, src_mem.begin() + 800, dst_mem.begin() + 200));
+    MEM64_CHECK(src.reads == 0 && dst.writes == 0);
+}
+
+static void test_direct_overlap()
+{
+    auto mem{pattern(64)};
+    auto expected{mem};
+    std::copy(expected.begin() + 4, expected.begin() + 36, expected.begin() + 8);
+    DirectVecHandle hdl{mem};
+
+    copy(hdl, 4, hdl, 8, 32);
+
+    MEM64_CHECK(mem == expected);
+}
+
+static void test_one_sided_direct()
+{
+    auto src_mem{pattern(4096)};
+    std::vector<std::uint8_t> dst_mem(4096);
+    DirectVecHandle direct{src_mem};
+    VecHandle slow{dst_mem};
+
+    copy(direct, 16, slow, 32, 4000);
+    MEM64_CHECK(std::equal(src_mem.begin() + 16, src_mem.begin() + 4016, dst_mem.begin() + 32));
+    MEM64_CHECK(slow.writes == 1);
+
+    std::vector<std::uint8_t> back_mem(4096);
+    DirectVecHandle back{back_mem};
+
+    copy(slow, 32, back, 8, 4000);
+    MEM64_CHECK(std::equal(src_mem.begin() + 16, src_mem.begin() + 4016, back_mem.begin() + 8));
+    MEM64_CHECK(slow.reads == 1);
+}
+
+static void test_chunked()
+{
+    auto src_mem{pattern(10000)};
+    std::vector<std::uint8_t> dst_mem(10000);
+    VecHandle src{src_mem}, dst{dst_mem};
+
+    copy(src, 1, dst, 3, 9990, CopyOptions{1024, false});
+
+    MEM64_CHECK(std::equal(src_mem.begin() + 1, src_mem.begin() + 9991, dst_mem.begin() + 3));
+    MEM64_CHECK(src.reads == 10 && dst.writes == 10);
+}
+
+static void test_pipelined()
+{
+    auto src_mem{pattern(100000)};
+    std::vector<std::uint8_t> dst_mem(100000);
+    VecHandle src{src_mem}, dst{dst_mem};
+
+    copy(src, 8, dst, 8, 99000, CopyOptions{4096, true});
+
+    MEM64_CHECK(std::equal(src_mem.begin() + 8, src_mem.begin() + 99008, dst_mem.begin() + 8));
+    MEM64_CHECK(src.reads == 25 && dst.writes == 25);
+}
+
+static void test_pipelined_errors()
+{
+    auto src_mem{pattern(10000)};
+    std::vector<std::uint8_t> small_mem(5000), dst_mem(10000);
+    VecHandle src{src_mem}, small{small_mem}, dst{dst_mem};
+
+    // Reader fails part way through
+    MEM64_CHECK_THROWS(copy(small, 0, dst, 0, 8000, CopyOptions{1024, true}), std::out_of_range);
+
+    // Writer fails part way through
+    MEM64_CHECK_THROWS(copy(src, 0, small, 0, 8000, CopyOptions{1024, true}), std::out_of_range);
+}
+
+static void test_empty()
+{
+    std::vector<std::uint8_t> mem(16);
+    VecHandle hdl{mem};
+
+    copy(hdl, 0, hdl, 8, 0, CopyOptions{4, true});
+
+    MEM64_CHECK(hdl.reads == 0 && hdl.writes == 0);
+}
+
+int main()
+{
+    test_direct_to_direct();
+    test_direct_overlap();
+    test_one_sided_direct();
+    test_chunked();
+    test_pipelined();
+    test_pipelined_errors();
+    test_empty();
+    return finish();
+}
@@ -0,0 +1,144 @@
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "mem64/mem64.hpp"
+#include "mem64/cstring.hpp"
+#include "fake_handle.hpp"
+#include "test_util.hpp"
+
+using namespace Mem64;
+using namespace Mem64Test;
+
+
+static void put(std::vector<std::uint8_t>& mem, std::size_t addr, const char* str)
+{
+    std::memcpy(mem.data() + addr, str, std::strlen(str) + 1);
+}
+
+template<typename THandle>
+static void test_read_cstr()
+{
+    std::vector<std::uint8_t> mem(256, 'x');
+    THandle hdl{mem};
+    std::string buf;
+
+    put(mem, 60, "crosses a block");
+    MEM64_CHECK(read_cstr(hdl, 60, buf, 100) == "crosses a block");
+
+    put(mem, 8, "");
+    MEM64_CHECK(read_cstr(hdl, 8, buf, 100).empty());
+
+    // Bounded by max_len when no terminator is found
+    MEM64_CHECK(read_cstr(hdl, 60, buf, 5) == "cross");
+
+    // Terminated right before the end of the buffer, reads must stop at the terminator block
+    put(mem, 240, "tail");
+    MEM64_CHECK(read_cstr(hdl, 240, buf, 1000) == "tail");
+
+    mem[200] = 'a';
+    mem[201] = 'b';
+    mem[202] = 0xFF;
+    MEM64_CHECK(read_cstr(hdl, 200, buf, 10, 0xFF) == "ab");
+}
+
+static void test_chunked_reads()
+{
+    std::vector<std::uint8_t> mem(256, 'x');
+    VecHandle hdl{mem};
+    std::string buf;
+
+    put(mem, 60, "0123456789");
+    read_cstr(hdl, 60, buf, 100);
+    MEM64_CHECK(hdl.reads == 2);
+
+    hdl.reads.reset();
+    put(mem, 1, std::string(150, 'y').c_str());
+    MEM64_CHECK(read_cstr(hdl, 1, buf, 200).size() == 150);
+    MEM64_CHECK(hdl.reads == 3);
+}
+
+template<typename THandle>
+static void test_write_cstr()
+{
+    std::vector<std::uint8_t> mem(64, 'x');
+    THandle hdl{mem};
+    std::string buf;
+
+    write_cstr(hdl, 4, "hello", 16);
+    MEM64_CHECK(read_fixed_str(hdl, 4, buf, 16) == "hello");
+
+    // Truncated so the terminator fits
+    write_cstr(hdl, 4, "hello world", 6);
+    MEM64_CHECK(mem[9] == 0 && mem[10] == 'x');
+    MEM64_CHECK(read_cstr(hdl, 4, buf, 64) == "hello");
+
+    write_cstr(hdl, 20, "abc", 1);
+    MEM64_CHECK(mem[20] == 0 && mem[21] == 'x');
+
+    write_cstr(hdl, 30, "abc", 0);
+    MEM64_CHECK(mem[30] == 'x');
+
+    // Fixed buffer without terminator uses the whole buffer
+    std::memcpy(mem.data() + 40, "full", 4);
+    MEM64_CHECK(read_fixed_str(hdl, 40, buf, 4) == "full");
+}
+
+static void test_refs_and_ptrs()
+{
+    std::vector<std::uint8_t> mem(128);
+    VecHandle hdl{mem};
+    std::string buf;
+
+    Ref<char[8], VecHandle> name{hdl, 16};
+    name.assign("mario and luigi");
+    MEM64_CHECK(name.str(buf) == "mario a");
+    MEM64_CHECK(hdl.reads == 1);
+
+    Ref<const char[8], VecHandle> const_name{name};
+    MEM64_CHECK(const_name.str(buf) == "mario a");
+
+    Ptr<char, VecHandle> ptr{hdl, 64};
+    write_cstr(ptr, "peach", 32);
+    MEM64_CHECK(read_cstr(ptr, buf, 32) == "peach");
+
+    Ptr<const char, VecHandle> const_ptr{hdl, 64};
+    MEM64_CHECK(read_cstr(const_ptr, buf, 3) == "pea");
+}
+
+static void test_text_table()
+{
+    // Toy table: digits at 0x00.., letters at 0x0A.., space 0x9E, terminator 0xFF
+    std::array<char, 256> decode;
+    decode.fill('?');
+    for(int i{}; i < 10; ++i)
+        decode[i] = static_cast<char>('0' + i);
+    for(int i{}; i < 26; ++i)
+        decode[0x0A + i] = static_cast<char>('A' + i);
+    decode[0x9E] = ' ';
+    TextTable table{decode, 0xFF, 0x9E};
+
+    std::vector<std::uint8_t> mem(64, 0xEE);
+    VecHandle hdl{mem};
+    std::string buf;
+
+    write_text(hdl, 8, "BOB 64", 32, table);
+    MEM64_CHECK(mem[8] == 0x0B && mem[11] == 0x9E && mem[13] == 0x04 && mem[14] == 0xFF);
+    MEM64_CHECK(read_text(hdl, 8, buf, 32, table) == "BOB 64");
+
+    // Unmapped host characters encode to the fallback
+    write_text(hdl, 8, "A!", 32, table);
+    MEM64_CHECK(read_text(hdl, 8, buf, 32, table) == "A ");
+}
+
+int main()
+{
+    test_read_cstr<VecHandle>();
+    test_read_cstr<DirectVecHandle>();
+    test_chunked_reads();
+    test_write_cstr<VecHandle>();
+    test_write_cstr<DirectVecHandle>();
+    test_refs_and_ptrs();
+    test_text_table();
+    return finish();
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include "mem64/handle_traits.hpp"
+
+
+namespace Mem64Test
+{
+
+/// Call counter that stays copyable so the handle owning it does
+struct Counter
+{
+    Counter() = default;
+
+    Counter(const Counter& other):
+        value_{other.value_.load()}
+    {}
+
+    Counter& operator=(const Counter& other)
+    {
+        value_ = other.value_.load();
+        return *this;
+    }
+
+    void operator++()
+    {
+        value_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    operator std::size_t() const
+    {
+        return value_.load();
+    }
+
+    void reset()
+    {
+        value_ = 0;
+    }
+
+private:
+    std::atomic<std::size_t> value_{};
+};
+
+/// Bounds checked handle over a host buffer, stands in for emulator RDRAM
+///
+/// Accesses outside the buffer throw std::out_of_range. A latency busy waits on every call to model
+/// handles that cross a process boundary.
+template<bool SWAP>
+struct BasicVecHandle
+{
+    using addr_t = std::uint32_t;
+    using saddr_t = std::int32_t;
+    using usize_t = std::uint32_t;
+    using ssize_t = std::int32_t;
+
+    static constexpr addr_t INVALID_OFFSET{0};
+    static constexpr bool SWAP_BYTES{SWAP};
+
+
+    explicit BasicVecHandle(std::vector<std::uint8_t>& mem, std::chrono::nanoseconds latency = {}):
+        mem_{&mem}, latency_{latency}
+    {}
+
+    void read_raw(addr_t offset, std::uint8_t data[], usize_t n)
+    {
+        check(offset, n);
+        std::memcpy(data, mem_->data() + offset, n);
+        ++reads;
+    }
+
+    void write_raw(addr_t offset, const std::uint8_t data[], usize_t n)
+    {
+        check(offset, n);
+        std::memcpy(mem_->data() + offset, data, n);
+        ++writes;
+    }
+
+    template<typename T>
+    T read(addr_t offset)
+    {
+        std::uint8_t bytes[sizeof(T)];
+        read_raw(offset, bytes, sizeof(T));
+        return Mem64::decode_raw<T>(bytes, SWAP);
+    }
+
+    template<typename T>
+    void write(addr_t offset, T val)
+    {
+        std::uint8_t bytes[sizeof(T)];
+        Mem64::encode_raw<T>(val, bytes, SWAP);
+        write_raw(offset, bytes, sizeof(T));
+    }
+
+    template<typename T>
+    static bool valid_offset(addr_t offset)
+    {
+        return (offset != INVALID_OFFSET) && (offset % alignof(T) == 0);
+    }
+
+    std::vector<std::uint8_t>& mem() const
+    {
+        return *mem_;
+    }
+
+    Counter reads;
+    Counter writes;
+
+protected:
+    void check(addr_t offset, usize_t n) const
+    {
+        if(static_cast<std::size_t>(offset) + n > mem_->size())
+            throw std::out_of_range{"access outside of fake RDRAM"};
+
+        if(latency_.count() > 0)
+        {
+            auto until{std::chrono::steady_clock::now() + latency_};
+            while(std::chrono::steady_clock::now() < until)
+            {}
+        }
+    }
+
+    std::vector<std::uint8_t>* mem_;
+    std::chrono::nanoseconds latency_;
+};
+
+using VecHandle = BasicVecHandle<false>;
+
+/// Big endian guest on a little endian host
+using SwapVecHandle = BasicVecHandle<true>;
+
+/// VecHandle that also exposes its buffer through host_ptr
+struct DirectVecHandle : VecHandle
+{
+    using VecHandle::VecHandle;
+
+    std::uint8_t* host_ptr(addr_t offset)
+    {
+        check(offset, 0);
+        return mem_->data() + offset;
+    }
+};
+
+} // Mem64Test
@@ -0,0 +1,130 @@
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+#include "mem64/mem64.hpp"
+#include "mem64/lazy.hpp"
+#include "fake_handle.hpp"
+#include "test_util.hpp"
+
+using namespace Mem64;
+using namespace Mem64Test;
+
+
+struct Player
+{
+    std::uint32_t action;
+    std::int16_t timer;
+    std::uint16_t coins;
+    std::uint32_t total;
+    std::uint32_t count;
+};
+
+static void test_fused_reads()
+{
+    std::vector<std::uint8_t> mem(0x1000);
+    VecHandle hdl{mem};
+    Ref<Player, VecHandle> player{hdl, 0x100};
+    Ref<std::uint32_t, VecHandle> far{hdl, 0x800};
+
+    player.field(&Player::action) = 3u;
+    player.field(&Player::timer) = std::int16_t{12};
+    player.field(&Player::coins) = std::uint16_t{40};
+    far = 7u;
+
+    hdl.reads.reset();
+    auto idle{lazy(player.field(&Player::action)) == 3u && lazy(player.field(&Player::timer)) > 10};
+    MEM64_CHECK(hdl.reads == 0);
+
+    // Both fields come from one read
+    MEM64_CHECK(static_cast<bool>(idle));
+    MEM64_CHECK(hdl.reads == 1);
+
+    auto sum{lazy(player.field(&Player::coins)) + lazy(far) * 2};
+    MEM64_CHECK(sum.value() == 54);
+    MEM64_CHECK(hdl.reads == 3);
+
+    MEM64_CHECK((~lazy(far)).value() == ~7u && !(!lazy(far)).value());
+}
+
+static void test_short_circuit()
+{
+    std::vector<std::uint8_t> mem(0x100);
+    VecHandle hdl{mem};
+    Ref<std::uint32_t, VecHandle> total{hdl, 0x10}, count{hdl, 0x14};
+    total = 100u;
+    count = 0u;
+
+    // The right side would divide by zero if it was evaluated
+    MEM64_CHECK(!(lazy(count) != 0u && lazy(total) / lazy(count) > 5u));
+    MEM64_CHECK((lazy(count) == 0u || lazy(total) % lazy(count) == 1u).value());
+
+    count = 10u;
+    MEM64_CHECK((lazy(count) != 0u && lazy(total) / lazy(count) == 10u).value());
+    MEM64_CHECK(!(lazy(count) == 0u || lazy(total) % lazy(count) == 1u));
+
+    // Results of && and || are plain bools like the builtins
+    static_assert(std::is_same_v<decltype((lazy(count) && lazy(total)).value()), bool>);
+}
+
+static void test_eager_operand()
+{
+    std::vector<std::uint8_t> mem(0x100);
+    VecHandle hdl{mem};
+    Ref<std::uint32_t, VecHandle> action{hdl, 0x10}, timer{hdl, 0x20};
+    action = 3u;
+    timer = 5u;
+
+    // A bare Ref comparison is read when the expression is built, only the lazy side is deferred
+    hdl.reads.reset();
+    auto mixed{action == 3u && lazy(timer) > 0u};
+    MEM64_CHECK(hdl.reads == 1);
+
+    action = 4u;
+    MEM64_CHECK(mixed.value());
+    MEM64_CHECK(!(lazy(action) == 3u && lazy(timer) > 0u));
+}
+
+static void test_byte_order()
+{
+    std::vector<std::uint8_t> mem(0x100);
+    SwapVecHandle hdl{mem};
+    Ref<std::uint32_t, SwapVecHandle> a{hdl, 0x10}, b{hdl, 0x14};
+    a = 0x01000000u;
+    b = 0x00000002u;
+
+    MEM64_CHECK((lazy(a) + lazy(b)).value() == 0x01000002u);
+    MEM64_CHECK(hdl.reads == 1);
+}
+
+static void test_raw_type_arithmetic()
+{
+    std::vector<std::uint8_t> mem(0x100);
+    VecHandle hdl{mem};
+    Ref<std::uint16_t, VecHandle> a{hdl, 0x10}, b{hdl, 0x12};
+    Ref<std::uint8_t, VecHandle> small{hdl, 0x14};
+    a = std::uint16_t{1};
+    b = std::uint16_t{2};
+    small = std::uint8_t{200};
+
+    // Results wrap in the raw type like the eager operators instead of promoting to int
+    static_assert(std::is_same_v<decltype((lazy(a) - lazy(b)).value()), std::uint16_t>);
+    static_assert(std::is_same_v<decltype((lazy(a) * 3).value()), std::uint16_t>);
+    MEM64_CHECK(a - b > 100);
+    MEM64_CHECK((lazy(a) - lazy(b) > 100).value());
+    MEM64_CHECK((lazy(a) - 2 > 100).value());
+    MEM64_CHECK((lazy(small) + lazy(small)).value() == small + small);
+    MEM64_CHECK((~lazy(small)).value() == ~small);
+
+    // Mixed Refs use their common type
+    MEM64_CHECK((lazy(small) + lazy(a) == 201).value());
+}
+
+int main()
+{
+    test_fused_reads();
+    test_short_circuit();
+    test_eager_operand();
+    test_byte_order();
+    test_raw_type_arithmetic();
+    return finish();
+}
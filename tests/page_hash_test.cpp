@@ -0,0 +1,130 @@
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "mem64/page_hash.hpp"
+#include "alloc_counter.hpp"
+#include "fake_handle.hpp"
+#include "test_util.hpp"
+
+using namespace Mem64;
+using namespace Mem64Test;
+
+
+template<typename THandle>
+static std::vector<std::size_t> dirty_pages(const PageHashIndex<THandle>& index)
+{
+    std::vector<std::size_t> pages;
+    for(std::size_t page{}; page < index.page_count(); ++page)
+        if(index.dirty(page))
+            pages.push_back(page);
+    return pages;
+}
+
+template<typename THandle>
+static void test_dirty_pages()
+{
+    // Region starts mid buffer and ends with a partial page
+    std::vector<std::uint8_t> mem(16 + 5 * 4096 + 100);
+    THandle hdl{mem};
+    PageHashIndex<THandle> index{hdl, 16, 5 * 4096 + 100};
+
+    MEM64_CHECK(index.page_count() == 6);
+
+    index.update();
+    MEM64_CHECK(dirty_pages(index).size() == 6);
+    MEM64_CHECK(index.epoch() == 1);
+
+    index.update();
+    MEM64_CHECK(dirty_pages(index).empty());
+
+    mem[16 + 4095] = 1;
+    mem[16 + 3 * 4096] = 2;
+    mem[16 + 5 * 4096 + 99] = 3;
+    mem[15] = 4; // outside the region
+
+    index.update();
+    MEM64_CHECK((dirty_pages(index) == std::vector<std::size_t>{0, 3, 5}));
+    MEM64_CHECK(index.dirty_bitmap()[0] == 0b101001);
+
+    index.reset();
+    index.update();
+    MEM64_CHECK(dirty_pages(index).size() == 6);
+}
+
+static void test_threads_match_single()
+{
+    constexpr std::size_t PAGES{4000};
+    std::vector<std::uint8_t> mem(PAGES * 4096 + 4096);
+    VecHandle single_hdl{mem}, multi_hdl{mem};
+    PageHashIndex<VecHandle> single{single_hdl, 4096, PAGES * 4096, 1},
+                             multi{multi_hdl, 4096, PAGES * 4096, 4};
+
+    for(int round{}; round < 20; ++round)
+    {
+        for(std::size_t i{}; i < 50; ++i)
+            mem[4096 + (i * 7919 + round * 104729) % (PAGES * 4096)] ^= static_cast<std::uint8_t>(round + 1);
+
+        MEM64_CHECK(single.update() == multi.update());
+    }
+
+    MEM64_CHECK(single_hdl.reads == multi_hdl.reads);
+}
+
+static void test_no_update_allocation()
+{
+    constexpr std::size_t PAGES{2000};
+    std::vector<std::uint8_t> mem(PAGES * 4096);
+
+    for(unsigned threads : {1u, 4u})
+    {
+        VecHandle hdl{mem};
+        PageHashIndex<VecHandle> index{hdl, 0, PAGES * 4096, threads};
+        index.update();
+
+        // Read buffers and workers are kept, later updates allocate nothing
+        auto before{allocations().load()};
+        for(int round{}; round < 10; ++round)
+        {
+            mem[static_cast<std::size_t>(round) * 4096 * 150] ^= 1;
+            index.update();
+        }
+        MEM64_CHECK(allocations().load() == before);
+    }
+}
+
+static void test_errors_propagate()
+{
+    std::vector<std::uint8_t> mem(1000 * 4096);
+    VecHandle hdl{mem};
+
+    // Region runs past the end of the fake RDRAM, the failing read happens on a worker
+    PageHashIndex<VecHandle> index{hdl, 0, 2000 * 4096, 4};
+    MEM64_CHECK_THROWS(index.update(), std::out_of_range);
+    MEM64_CHECK_THROWS(index.update(), std::out_of_range);
+}
+
+static void test_hash()
+{
+    std::vector<std::uint8_t> a(4096, 7), b(4096, 7);
+    MEM64_CHECK(detail::hash_bytes(a.data(), a.size()) == detail::hash_bytes(b.data(), b.size()));
+
+    for(std::size_t pos : {0u, 31u, 32u, 4000u, 4095u})
+    {
+        b[pos] ^= 0x10;
+        MEM64_CHECK(detail::hash_bytes(a.data(), a.size()) != detail::hash_bytes(b.data(), b.size()));
+        b[pos] ^= 0x10;
+    }
+
+    MEM64_CHECK(detail::hash_bytes(a.data(), 100) != detail::hash_bytes(a.data(), 101));
+}
+
+int main()
+{
+    test_dirty_pages<VecHandle>();
+    test_dirty_pages<DirectVecHandle>();
+    test_threads_match_single();
+    test_no_update_allocation();
+    test_errors_propagate();
+    test_hash();
+    return finish();
+}
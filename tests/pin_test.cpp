@@ -0,0 +1,162 @@
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "mem64/mem64.hpp"
+#include "mem64/any_handle.hpp"
+#include "fake_handle.hpp"
+#include "test_util.hpp"
+
+using namespace Mem64;
+using namespace Mem64Test;
+
+
+static void test_copy_pin()
+{
+    std::vector<std::uint8_t> mem(0x100);
+    VecHandle hdl{mem};
+    Ref<std::uint32_t[4], VecHandle> values{hdl, 0x10};
+    for(std::uint32_t i{}; i < 4; ++i)
+        values[i] = i + 1;
+
+    auto view{values.pin()};
+    static_assert(std::is_same_v<decltype(view.data()), const std::uint32_t*>);
+    static_assert(!decltype(view)::ZERO_COPY);
+    MEM64_CHECK(view.size() == 4 && view.size_bytes() == 16);
+    MEM64_CHECK(view[0] == 1 && view[3] == 4);
+
+    hdl.writes.reset();
+    {
+        auto edit{values.pin_mut()};
+        edit[1] = 20;
+        MEM64_CHECK(mem[0x14] == 2);
+
+        edit.flush();
+        MEM64_CHECK(mem[0x14] == 20);
+    }
+    MEM64_CHECK(hdl.writes == 1);
+
+    // The copy taken by view is not refreshed
+    MEM64_CHECK(view[1] == 2);
+}
+
+static void test_no_implicit_write_back()
+{
+    std::vector<std::uint8_t> mem(0x100);
+    VecHandle hdl{mem};
+    Ref<std::uint8_t[16], VecHandle> buffer{hdl, 0x20};
+
+    // A guest update while a writable pin is alive survives the pin going away
+    {
+        auto edit{buffer.pin_mut()};
+        mem[0x22] = 0x77;
+    }
+    MEM64_CHECK(mem[0x22] == 0x77);
+    MEM64_CHECK(hdl.writes == 0);
+
+    {
+        auto view{buffer.pin()};
+        mem[0x23] = 0x66;
+    }
+    MEM64_CHECK(mem[0x23] == 0x66 && hdl.writes == 0);
+}
+
+static void test_direct_pin()
+{
+    std::vector<std::uint8_t> mem(0x100);
+    DirectVecHandle hdl{mem};
+    Ptr<std::uint16_t, DirectVecHandle> ptr{hdl, 0x40};
+
+    auto edit{ptr.span_mut(8)};
+    static_assert(decltype(edit)::ZERO_COPY);
+    MEM64_CHECK(edit.bytes() == mem.data() + 0x40);
+
+    edit[2] = 0xBEEF;
+    MEM64_CHECK(ptr[2].read() == 0xBEEF);
+
+    auto view{ptr.span(8)};
+    static_assert(std::is_same_v<decltype(view.bytes()), const std::uint8_t*>);
+    MEM64_CHECK(view.data() == edit.data());
+    MEM64_CHECK(hdl.reads == 1 && hdl.writes == 0);
+}
+
+static void test_const_and_move()
+{
+    std::vector<std::uint8_t> mem(0x100);
+    VecHandle hdl{mem};
+    Ptr<const std::uint32_t, VecHandle> ptr{hdl, 0x30};
+    mem[0x30] = 0x12;
+    mem[0x33] = 0x34;
+
+    // Pins of const objects stay read only, even the mutable variant
+    auto pinned{ptr.span_mut(2)};
+    static_assert(std::is_same_v<decltype(pinned.data()), const std::uint32_t*>);
+    MEM64_CHECK(pinned[0] == 0x34000012u);
+
+    auto moved{std::move(pinned)};
+    MEM64_CHECK(moved.size() == 2 && moved.bytes()[0] == 0x12 && moved[0] == 0x34000012u);
+}
+
+static void test_swapped_handles()
+{
+    std::vector<std::uint8_t> mem(0x100);
+    mem[0x30] = 0x12;
+    mem[0x33] = 0x34;
+
+    // Byte swapping handles pin raw bytes only
+    SwapVecHandle hdl{mem};
+    Ptr<std::uint32_t, SwapVecHandle> value{hdl, 0x30};
+    auto raw{Ptr<const std::uint8_t, SwapVecHandle>{hdl, 0x30}.span(8)};
+    MEM64_CHECK(decode_raw<std::uint32_t>(raw.bytes(), true) == (*value).read());
+
+    // Runtime byte order is checked when pinning
+    AnyHandle any{SwapVecHandle{mem}};
+    Ptr<std::uint32_t, AnyHandle> any_value{any, 0x30};
+    Ptr<std::uint8_t, AnyHandle> any_bytes{any, 0x30};
+    MEM64_CHECK_THROWS(any_value.span(2), std::invalid_argument);
+    MEM64_CHECK(any_bytes.span(4)[3] == 0x34);
+
+    AnyHandle native{VecHandle{mem}};
+    Ptr<std::uint32_t, AnyHandle> native_value{native, 0x30};
+    MEM64_CHECK(native_value.span(1)[0] == 0x34000012u);
+}
+
+static void test_visit_bytes()
+{
+    std::vector<std::uint8_t> mem(0x1000);
+    for(std::size_t i{}; i < mem.size(); ++i)
+        mem[i] = static_cast<std::uint8_t>(i);
+
+    VecHandle hdl{mem};
+    std::vector<std::uint8_t> seen;
+    std::size_t calls{};
+
+    visit_bytes(hdl, 0x10, 1000, 256, [&](std::size_t offset, const std::uint8_t* data, std::size_t n)
+    {
+        MEM64_CHECK(offset == seen.size() && n <= 256);
+        seen.insert(seen.end(), data, data + n);
+        ++calls;
+    });
+    MEM64_CHECK(calls == 4 && seen.size() == 1000 && seen[999] == mem[0x10 + 999]);
+
+    DirectVecHandle direct{mem};
+    calls = 0;
+    visit_bytes(direct, 0x10, 1000, 256, [&](std::size_t, const std::uint8_t* data, std::size_t n)
+    {
+        MEM64_CHECK(data == mem.data() + 0x10 && n == 1000);
+        ++calls;
+    });
+    MEM64_CHECK(calls == 1);
+}
+
+int main()
+{
+    test_copy_pin();
+    test_no_implicit_write_back();
+    test_direct_pin();
+    test_const_and_move();
+    test_swapped_handles();
+    test_visit_bytes();
+    return finish();
+}
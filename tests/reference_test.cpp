@@ -0,0 +1,177 @@
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+#include "mem64/mem64.hpp"
+#include "fake_handle.hpp"
+#include "test_util.hpp"
+
+using namespace Mem64;
+using namespace Mem64Test;
+
+
+struct Player
+{
+    std::uint32_t action;
+    float pos[3];
+    std::int16_t health;
+    std::uint8_t* name;
+};
+
+/// Handle with heavy state, Refs and Ptrs must not grow with it
+struct HeavyHandle
+{
+    using addr_t = std::uintptr_t;
+    using saddr_t = std::intptr_t;
+    using usize_t = std::size_t;
+    using ssize_t = std::ptrdiff_t;
+
+    static constexpr addr_t INVALID_OFFSET{0};
+
+    std::uint8_t state[256];
+};
+
+template<typename T>
+constexpr bool is_two_words_v{sizeof(T) == 2 * sizeof(void*)};
+
+template<typename T>
+constexpr bool is_cheap_ref_v{is_two_words_v<T> && std::is_trivially_copyable_v<T>};
+
+static_assert(is_cheap_ref_v<Ref<std::uint32_t, VecHandle>>);
+static_assert(is_cheap_ref_v<Ref<Player, VecHandle>>);
+static_assert(is_cheap_ref_v<Ptr<Player, VecHandle>>);
+static_assert(is_two_words_v<Ref<std::uint8_t*, VecHandle>>);
+
+static_assert(is_cheap_ref_v<Ref<std::uint32_t, HeavyHandle>>);
+static_assert(is_cheap_ref_v<Ref<const float, HeavyHandle>>);
+static_assert(is_cheap_ref_v<Ref<std::uint16_t[8], HeavyHandle>>);
+static_assert(is_cheap_ref_v<Ref<Player, HeavyHandle>>);
+static_assert(is_cheap_ref_v<Ptr<Player, HeavyHandle>>);
+
+// Assigning a Ref to pointer writes the pointer, so only copy construction is trivial
+static_assert(is_two_words_v<Ref<std::uint32_t*, HeavyHandle>>);
+static_assert(std::is_trivially_copy_constructible_v<Ref<std::uint32_t*, HeavyHandle>>);
+
+template<typename TRef, typename = void>
+struct is_assignable_ref : std::false_type
+{};
+
+template<typename TRef>
+struct is_assignable_ref<TRef, std::void_t<decltype(std::declval<const TRef&>() = 1)>> : std::true_type
+{};
+
+static_assert(is_assignable_ref<Ref<std::uint32_t, VecHandle>>::value);
+static_assert(!is_assignable_ref<Ref<const std::uint32_t, VecHandle>>::value);
+
+
+static void test_shared_handle()
+{
+    std::vector<std::uint8_t> mem(0x1000);
+    VecHandle hdl{mem};
+
+    Ptr<Player, VecHandle> players{hdl, 0x100};
+    for(std::uint32_t i{}; i < 4; ++i)
+    {
+        auto player{players[i]};
+        player.field(&Player::action) = 0x100 + i;
+        player.field(&Player::pos)[1] = static_cast<float>(i) * 2.0f;
+    }
+
+    auto copy{players};
+    std::uint32_t sum{};
+    for(int i{}; i < 4; ++i, ++copy)
+        sum += copy->field(&Player::action).read();
+
+    // Every Ref and Ptr derived from hdl counts on the same handle object
+    MEM64_CHECK(sum == 0x400 + 6);
+    MEM64_CHECK(hdl.writes == 8 && hdl.reads == 4);
+    MEM64_CHECK(&players[3].hdl() == &hdl);
+    MEM64_CHECK(static_cast<float>(players[2].field(&Player::pos)[1]) == 4.0f);
+}
+
+static void test_const_refs()
+{
+    std::vector<std::uint8_t> mem(0x100);
+    VecHandle hdl{mem};
+
+    Ref<std::uint32_t, VecHandle> value{hdl, 0x10};
+    value = 77u;
+
+    Ref<const std::uint32_t, VecHandle> const_value{value};
+    MEM64_CHECK(const_value.read() == 77u);
+    MEM64_CHECK(&const_value.hdl() == &hdl && const_value.offset() == 0x10);
+
+    Ref<const Player, VecHandle> const_player{hdl, 0x20};
+    static_assert(std::is_same_v<decltype(const_player.field(&Player::health)),
+                                 const Ref<const std::int16_t, VecHandle>>);
+}
+
+static void test_pointer_refs()
+{
+    std::vector<std::uint8_t> mem_a(0x100), mem_b(0x100);
+    VecHandle hdl_a{mem_a}, hdl_b{mem_b};
+
+    Ref<std::uint32_t*, VecHandle> ref_a{hdl_a, 0x10}, ref_b{hdl_b, 0x20};
+    ref_b = Ptr<std::uint32_t, VecHandle>{hdl_b, 0x40};
+
+    // Assigning writes the pointer value but keeps the handle
+    ref_a = ref_b;
+    MEM64_CHECK(&ref_a.hdl() == &hdl_a);
+    MEM64_CHECK(ref_a.offset() == 0x40);
+
+    *ref_a = 5u;
+    MEM64_CHECK(mem_a[0x40] == 5 && mem_b[0x40] == 0);
+
+    ref_a += 2;
+    MEM64_CHECK(ref_a.offset() == 0x48);
+
+    auto old{ref_a++};
+    MEM64_CHECK(old.offset() == 0x48 && ref_a.offset() == 0x4C);
+}
+
+static void test_ptr_arithmetic()
+{
+    std::vector<std::uint8_t> mem(0x100);
+    VecHandle hdl_a{mem}, hdl_b{mem};
+
+    Ptr<std::uint16_t, VecHandle> p{hdl_a, 0x10};
+    auto old{p++};
+    MEM64_CHECK(old.offset() == 0x10 && p.offset() == 0x12);
+
+    old = p--;
+    MEM64_CHECK(old.offset() == 0x12 && p.offset() == 0x10);
+
+    MEM64_CHECK((p + 3).offset() == 0x16 && (p + 3 - 1).offset() == 0x14);
+
+    // Equality compares the handle as well
+    MEM64_CHECK(p == (Ptr<std::uint16_t, VecHandle>{hdl_a, 0x10}));
+    MEM64_CHECK(p != (Ptr<std::uint16_t, VecHandle>{hdl_b, 0x10}));
+
+    auto const_p{static_cast<Ptr<const std::uint16_t, VecHandle>>(p)};
+    MEM64_CHECK(const_p.offset() == 0x10 && const_p.hdl() == &hdl_a);
+
+    Ptr<std::uint16_t, VecHandle> invalid{hdl_a};
+    MEM64_CHECK(!invalid.valid() && p.valid());
+}
+
+static void test_swapped_handle()
+{
+    std::vector<std::uint8_t> mem(0x100);
+    SwapVecHandle hdl{mem};
+
+    Ref<std::uint32_t, SwapVecHandle> value{hdl, 0x10};
+    value = 0x11223344u;
+
+    MEM64_CHECK(mem[0x10] == 0x11 && mem[0x13] == 0x44);
+    MEM64_CHECK(value.read() == 0x11223344u);
+}
+
+int main()
+{
+    test_shared_handle();
+    test_const_refs();
+    test_pointer_refs();
+    test_ptr_arithmetic();
+    test_swapped_handle();
+    return finish();
+}
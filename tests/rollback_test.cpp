@@ -0,0 +1,104 @@
+#include <cstdint>
+#include <vector>
+#include "mem64/rollback.hpp"
+#include "alloc_counter.hpp"
+#include "fake_handle.hpp"
+#include "test_util.hpp"
+
+using namespace Mem64;
+using namespace Mem64Test;
+
+
+constexpr std::uint32_t BASE{0x1000};
+constexpr std::uint32_t SIZE{10 * 4096 + 100};
+
+static void scribble(std::vector<std::uint8_t>& mem, std::uint32_t seed)
+{
+    // A few pages change every frame, including the partial last one
+    for(std::uint32_t i{}; i < 3; ++i)
+        mem[BASE + ((seed * 7 + i * 3) % 10) * 4096 + seed % 4096] = static_cast<std::uint8_t>(seed + i + 1);
+    mem[BASE + SIZE - 1] = static_cast<std::uint8_t>(seed);
+}
+
+static std::vector<std::uint8_t> region(const std::vector<std::uint8_t>& mem)
+{
+    return {mem.begin() + BASE, mem.begin() + BASE + SIZE};
+}
+
+template<typename THandle>
+static void test_save_restore()
+{
+    std::vector<std::uint8_t> mem(BASE + SIZE + 0x1000);
+    THandle hdl{mem};
+    RollbackRing<THandle> ring{hdl, BASE, SIZE, 4};
+
+    std::vector<std::vector<std::uint8_t>> states;
+    for(std::uint32_t frame{}; frame < 6; ++frame)
+    {
+        scribble(mem, frame);
+        ring.save();
+        states.push_back(region(mem));
+    }
+
+    // Only the newest four states are kept
+    MEM64_CHECK(ring.frame_count() == 4 && ring.capacity() == 4);
+    MEM64_CHECK(!ring.restore(4));
+
+    scribble(mem, 100);
+    MEM64_CHECK(ring.restore(0));
+    MEM64_CHECK(region(mem) == states[5]);
+    MEM64_CHECK(ring.stats().pages_restored == 4);
+
+    MEM64_CHECK(ring.restore(2));
+    MEM64_CHECK(region(mem) == states[3]);
+    MEM64_CHECK(ring.frame_count() == 2);
+
+    // Memory outside the region is left alone
+    mem[BASE - 1] = 0xEE;
+    MEM64_CHECK(ring.restore(1));
+    MEM64_CHECK(region(mem) == states[2] && mem[BASE - 1] == 0xEE);
+
+    // Saving continues from the restored state
+    scribble(mem, 200);
+    ring.save();
+    scribble(mem, 300);
+    MEM64_CHECK(ring.restore(1));
+    MEM64_CHECK(region(mem) == states[2]);
+}
+
+template<typename THandle>
+static void test_no_steady_state_allocation()
+{
+    std::vector<std::uint8_t> mem(BASE + SIZE);
+    THandle hdl{mem};
+    RollbackRing<THandle> ring{hdl, BASE, SIZE, 8};
+
+    auto cycle{[&](std::uint32_t frame)
+    {
+        scribble(mem, frame);
+        ring.save();
+        if(frame % 5 == 4)
+            ring.restore(3);
+    }};
+
+    // Warm up until the page pool covers the working set
+    for(std::uint32_t frame{}; frame < 200; ++frame)
+        cycle(frame);
+
+    auto pool{ring.stats().pool_pages};
+    auto before{allocations().load()};
+    for(std::uint32_t frame{200}; frame < 400; ++frame)
+        cycle(frame);
+
+    MEM64_CHECK(allocations().load() == before);
+    MEM64_CHECK(ring.stats().pool_pages == pool);
+}
+
+int main()
+{
+    test_save_restore<VecHandle>();
+    test_save_restore<DirectVecHandle>();
+    test_no_steady_state_allocation<VecHandle>();
+    test_no_steady_state_allocation<DirectVecHandle>();
+    return finish();
+}
@@ -0,0 +1,210 @@
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "mem64/mem64.hpp"
+#include "mem64/struct_codec.hpp"
+#include "fake_handle.hpp"
+#include "test_util.hpp"
+
+using namespace Mem64;
+using namespace Mem64Test;
+
+
+enum class Action : std::uint32_t
+{
+    IDLE = 0x0C400201,
+    WALKING = 0x04000440
+};
+
+struct State
+{
+    std::uint32_t a;
+    std::int16_t health;
+    std::uint16_t coins;
+    float pos[3];
+    float angle;
+    Action action;
+};
+
+template<typename THandle>
+static StructCodec<State, THandle> make_codec()
+{
+    StructCodec<State, THandle> codec;
+    codec.add_field(&State::a)
+         .add_field(&State::health)
+         .add_field(&State::coins)
+         .add_field(&State::angle)
+         .add_field(&State::action, FieldEncoding::XOR);
+    return codec;
+}
+
+template<typename THandle>
+static void test_round_trip()
+{
+    std::vector<std::uint8_t> sender_mem(0x200), receiver_mem(0x200);
+    THandle sender_hdl{sender_mem}, receiver_hdl{receiver_mem};
+    Ref<State, THandle> sender{sender_hdl, 0x40}, receiver{receiver_hdl, 0x80};
+
+    auto encoder{make_codec<THandle>()}, decoder{make_codec<THandle>()};
+
+    for(std::uint32_t frame{}; frame < 20; ++frame)
+    {
+        sender.field(&State::a) = frame * 1000;
+        sender.field(&State::health) = static_cast<std::int16_t>(100 - static_cast<int>(frame) * 13);
+        if(frame % 3 == 0)
+            sender.field(&State::coins) = static_cast<std::uint16_t>(frame);
+        sender.field(&State::angle) = static_cast<float>(frame) * 0.37f;
+        sender.field(&State::action) = frame % 2 ? Action::WALKING : Action::IDLE;
+
+        std::vector<std::uint8_t> out;
+        encoder.encode(sender, out);
+        MEM64_CHECK(encoder.last_frame_bytes() == out.size());
+        MEM64_CHECK(decoder.decode(out.data(), out.size(), receiver) == out.size());
+
+        MEM64_CHECK(receiver.field(&State::a).read() == frame * 1000);
+        MEM64_CHECK(receiver.field(&State::health).read() == sender.field(&State::health).read());
+        MEM64_CHECK(receiver.field(&State::coins).read() == sender.field(&State::coins).read());
+        MEM64_CHECK(receiver.field(&State::angle).read() == sender.field(&State::angle).read());
+        MEM64_CHECK(receiver.field(&State::action).read() == sender.field(&State::action).read());
+    }
+
+    // An unchanged struct costs only the change mask
+    std::vector<std::uint8_t> out;
+    encoder.encode(sender, out);
+    MEM64_CHECK(out.size() == 1);
+    MEM64_CHECK(decoder.decode(out.data(), out.size(), receiver) == 1);
+}
+
+static void test_quantized()
+{
+    std::vector<std::uint8_t> sender_mem(0x100), receiver_mem(0x100);
+    VecHandle sender_hdl{sender_mem}, receiver_hdl{receiver_mem};
+    Ref<State, VecHandle> sender{sender_hdl, 0}, receiver{receiver_hdl, 0};
+
+    StructCodec<State, VecHandle> encoder, decoder;
+    encoder.add_field(&State::angle, FieldEncoding::DELTA, 0.01);
+    decoder.add_field(&State::angle, FieldEncoding::DELTA, 0.01);
+
+    for(int frame{}; frame < 10; ++frame)
+    {
+        sender.field(&State::angle) = -1.5f + static_cast<float>(frame) * 0.123f;
+
+        std::vector<std::uint8_t> out;
+        encoder.encode(sender, out);
+        decoder.decode(out.data(), out.size(), receiver);
+
+        MEM64_CHECK(std::fabs(receiver.field(&State::angle).read() - sender.field(&State::angle).read()) <= 0.005f);
+        MEM64_CHECK(out.size() <= 3);
+    }
+}
+
+static void test_truncated()
+{
+    std::vector<std::uint8_t> sender_mem(0x100), receiver_mem(0x100);
+    VecHandle sender_hdl{sender_mem}, receiver_hdl{receiver_mem};
+    Ref<State, VecHandle> sender{sender_hdl, 0}, receiver{receiver_hdl, 0};
+
+    auto encoder{make_codec<VecHandle>()}, decoder{make_codec<VecHandle>()};
+
+    // a needs a two byte varint, health comes after it in the keyframe
+    sender.field(&State::a) = 1000u;
+    sender.field(&State::health) = std::int16_t{-300};
+
+    std::vector<std::uint8_t> out;
+    encoder.encode(sender, out);
+    MEM64_CHECK(out.size() == 8);
+
+    // Every prefix is rejected without applying the fields it did contain
+    for(std::size_t n{}; n < out.size(); ++n)
+    {
+        MEM64_CHECK(decoder.decode(out.data(), n, receiver) == 0);
+        MEM64_CHECK(receiver.field(&State::a).read() == 0 && receiver.field(&State::health).read() == 0);
+    }
+    MEM64_CHECK(receiver_hdl.writes == 0);
+
+    // Retrying with the whole frame decodes against the untouched previous state
+    MEM64_CHECK(decoder.decode(out.data(), out.size(), receiver) == out.size());
+    MEM64_CHECK(receiver.field(&State::a).read() == 1000u);
+    MEM64_CHECK(receiver.field(&State::health).read() == -300);
+
+    sender.field(&State::a) = 1001u;
+    out.clear();
+    encoder.encode(sender, out);
+    MEM64_CHECK(decoder.decode(out.data(), out.size(), receiver) == out.size());
+    MEM64_CHECK(receiver.field(&State::a).read() == 1001u);
+}
+
+static void test_adjacent_writes()
+{
+    std::vector<std::uint8_t> sender_mem(0x100), receiver_mem(0x100);
+    VecHandle sender_hdl{sender_mem}, receiver_hdl{receiver_mem};
+    Ref<State, VecHandle> sender{sender_hdl, 0}, receiver{receiver_hdl, 0};
+
+    auto encoder{make_codec<VecHandle>()}, decoder{make_codec<VecHandle>()};
+    sender.field(&State::a) = 1u;
+    sender.field(&State::health) = std::int16_t{2};
+    sender.field(&State::coins) = std::uint16_t{3};
+    sender.field(&State::action) = Action::WALKING;
+
+    std::vector<std::uint8_t> out;
+    encoder.encode(sender, out);
+    decoder.decode(out.data(), out.size(), receiver);
+
+    // a, health and coins are contiguous, action stands alone
+    MEM64_CHECK(receiver_hdl.writes == 2);
+
+    // After a reset both sides send and expect full values again
+    encoder.reset();
+    decoder.reset();
+    out.clear();
+    encoder.encode(sender, out);
+    MEM64_CHECK(decoder.decode(out.data(), out.size(), receiver) == out.size());
+    MEM64_CHECK(receiver.field(&State::action).read() == Action::WALKING);
+}
+
+static void test_keyframe()
+{
+    std::vector<std::uint8_t> sender_mem(0x100), receiver_mem(0x100);
+    VecHandle sender_hdl{sender_mem}, receiver_hdl{receiver_mem};
+    Ref<State, VecHandle> sender{sender_hdl, 0}, receiver{receiver_hdl, 0};
+
+    auto encoder{make_codec<VecHandle>()}, decoder{make_codec<VecHandle>()};
+
+    // The receiver starts out different, zero valued fields still have to reach it
+    sender.field(&State::a) = 7u;
+    receiver.field(&State::coins) = std::uint16_t{5};
+    receiver.field(&State::action) = Action::WALKING;
+
+    std::vector<std::uint8_t> out;
+    encoder.encode(sender, out);
+    MEM64_CHECK(out[0] == 0x1F);
+    MEM64_CHECK(decoder.decode(out.data(), out.size(), receiver) == out.size());
+    MEM64_CHECK(receiver.field(&State::a).read() == 7u && receiver.field(&State::coins).read() == 0);
+    MEM64_CHECK(receiver.field(&State::action).read() == Action{});
+
+    // Only the first frame is a keyframe
+    out.clear();
+    encoder.encode(sender, out);
+    MEM64_CHECK(out.size() == 1);
+
+    // After a reset the receiver is resynchronized the same way
+    receiver.field(&State::coins) = std::uint16_t{9};
+    encoder.reset();
+    decoder.reset();
+    out.clear();
+    encoder.encode(sender, out);
+    MEM64_CHECK(out[0] == 0x1F);
+    MEM64_CHECK(decoder.decode(out.data(), out.size(), receiver) == out.size());
+    MEM64_CHECK(receiver.field(&State::coins).read() == 0 && receiver.field(&State::a).read() == 7u);
+}
+
+int main()
+{
+    test_round_trip<VecHandle>();
+    test_round_trip<SwapVecHandle>();
+    test_quantized();
+    test_truncated();
+    test_adjacent_writes();
+    test_keyframe();
+    return finish();
+}
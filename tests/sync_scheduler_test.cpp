@@ -0,0 +1,149 @@
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "mem64/mem64.hpp"
+#include "mem64/sync_scheduler.hpp"
+#include "fake_handle.hpp"
+#include "test_util.hpp"
+
+using namespace Mem64;
+using namespace Mem64Test;
+
+
+/// One emulator session with its own fake RDRAM
+struct FakeSession
+{
+    static constexpr std::uint32_t RDRAM_SIZE{0x10000};
+    static constexpr std::uint32_t FRAME_ADDR{0x8000};
+
+    FakeSession():
+        mem(RDRAM_SIZE), hdl{mem}
+    {}
+
+    void read()
+    {
+        frame = hdl.read<std::uint32_t>(FRAME_ADDR);
+        read_thread = std::this_thread::get_id();
+        ++reads;
+    }
+
+    void write()
+    {
+        // The write job sees the value its own read job fetched this tick
+        if(read_thread != std::this_thread::get_id() || reads != writes + 1)
+            ++order_errors;
+        hdl.write<std::uint32_t>(FRAME_ADDR, frame + 1);
+        ++writes;
+    }
+
+    std::vector<std::uint8_t> mem;
+    VecHandle hdl;
+    std::uint32_t frame{};
+    std::thread::id read_thread;
+    std::size_t reads{};
+    std::size_t writes{};
+    std::size_t order_errors{};
+};
+
+static void test_many_sessions(unsigned threads)
+{
+    constexpr std::size_t SESSIONS{96};
+    constexpr std::uint32_t TICKS{50};
+
+    SyncScheduler scheduler{threads};
+    MEM64_CHECK(scheduler.thread_count() == threads);
+
+    std::vector<std::unique_ptr<FakeSession>> sessions;
+    for(std::size_t i{}; i < SESSIONS; ++i)
+    {
+        sessions.push_back(std::make_unique<FakeSession>());
+        auto* s{sessions.back().get()};
+        scheduler.add_session([s]{ s->read(); }, [s]{ s->write(); });
+    }
+    MEM64_CHECK(scheduler.session_count() == SESSIONS);
+
+    for(std::uint32_t tick{}; tick < TICKS; ++tick)
+        scheduler.tick();
+
+    // Every session ran exactly once per tick, read before write, and only touched its own RDRAM
+    for(const auto& s : sessions)
+    {
+        MEM64_CHECK(s->reads == TICKS && s->writes == TICKS);
+        MEM64_CHECK(s->order_errors == 0);
+        MEM64_CHECK(s->hdl.reads == TICKS && s->hdl.writes == TICKS);
+        MEM64_CHECK(VecHandle{s->mem}.read<std::uint32_t>(FakeSession::FRAME_ADDR) == TICKS);
+    }
+
+    for(SyncScheduler::SessionId id{}; id < SESSIONS; ++id)
+    {
+        auto lat{scheduler.latency(id)};
+        MEM64_CHECK(lat.p50.count() > 0);
+        MEM64_CHECK(lat.p50 <= lat.p90 && lat.p90 <= lat.p99 && lat.p99 <= lat.max);
+    }
+}
+
+static void test_errors()
+{
+    std::vector<std::vector<std::uint8_t>> rdram(16, std::vector<std::uint8_t>(0x1000));
+    std::atomic<int> completed{};
+
+    SyncScheduler scheduler{3};
+    for(std::size_t i{}; i < rdram.size(); ++i)
+    {
+        auto* mem{&rdram[i]};
+        bool faulty{i == 5};
+
+        scheduler.add_session(
+            [mem, faulty]
+            {
+                // Reads past the end of this session's RDRAM
+                VecHandle hdl{*mem};
+                hdl.read<std::uint32_t>(faulty ? 0x1000 : 0x10);
+            },
+            [&completed]{ ++completed; });
+    }
+
+    MEM64_CHECK_THROWS(scheduler.tick(), std::out_of_range);
+    MEM64_CHECK(completed == 15);
+
+    // The failed session does not hold up the next tick
+    MEM64_CHECK_THROWS(scheduler.tick(), std::out_of_range);
+    MEM64_CHECK(completed == 30);
+}
+
+static void test_idle_and_growth()
+{
+    SyncScheduler scheduler{2};
+    scheduler.tick();
+
+    std::vector<std::unique_ptr<FakeSession>> sessions;
+    for(std::uint32_t round{1}; round <= 4; ++round)
+    {
+        // Sessions joining between ticks
+        for(int i{}; i < 8; ++i)
+        {
+            sessions.push_back(std::make_unique<FakeSession>());
+            auto* s{sessions.back().get()};
+            scheduler.add_session([s]{ s->read(); }, [s]{ s->write(); });
+        }
+        scheduler.tick();
+    }
+
+    for(std::size_t i{}; i < sessions.size(); ++i)
+        MEM64_CHECK(sessions[i]->writes == 4 - i / 8);
+
+    MEM64_CHECK(scheduler.latency(0).max.count() > 0);
+}
+
+int main()
+{
+    test_many_sessions(1);
+    test_many_sessions(4);
+    test_many_sessions(16);
+    test_errors();
+    test_idle_and_growth();
+    return finish();
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdio>
+
+
+namespace Mem64Test
+{
+
+inline int& failures()
+{
+    static int count{};
+    return count;
+}
+
+inline void fail(const char* what, const char* file, int line)
+{
+    std::printf("%s:%d: check failed: %s\n", file, line, what);
+    ++failures();
+}
+
+/// Exit code for main, reports the number of failed checks
+inline int finish()
+{
+    if(failures() > 0)
+        std::printf("%d check(s) failed\n", failures());
+    return failures() > 0 ? 1 : 0;
+}
+
+} // Mem64Test
+
+#define MEM64_CHECK(cond) \
+    ((cond) ? void() : Mem64Test::fail(#cond, __FILE__, __LINE__))
+
+#define MEM64_CHECK_THROWS(expr, exc) \
+    do \
+    { \
+        bool thrown_{}; \
+        try { expr; } catch(const exc&) { thrown_ = true; } \
+        if(!thrown_) \
+            Mem64Test::fail(#expr " throws " #exc, __FILE__, __LINE__); \
+    } while(false)
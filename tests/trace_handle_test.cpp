@@ -0,0 +1,196 @@
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "mem64/mem64.hpp"
+#include "mem64/trace_handle.hpp"
+#include "fake_handle.hpp"
+#include "test_util.hpp"
+
+using namespace Mem64;
+using namespace Mem64Test;
+
+
+/// Mixed scalar and raw accesses through a traced handle
+static void workload(TraceHandle<VecHandle>& hdl)
+{
+    Ref<std::uint32_t, TraceHandle<VecHandle>> coins{hdl, 0x40};
+    Ref<std::uint16_t, TraceHandle<VecHandle>> action{hdl, 0x200};
+
+    for(std::uint32_t i{}; i < 10; ++i)
+    {
+        coins = coins.read() + 1;
+        action = static_cast<std::uint16_t>(action.read() ^ i);
+
+        std::uint8_t block[24];
+        hdl.read_raw(0x100 + i * 8, block, sizeof(block));
+        block[0] = static_cast<std::uint8_t>(i);
+        hdl.write_raw(0x180 - i * 16, block, sizeof(block));
+    }
+}
+
+static void test_record_replay()
+{
+    std::vector<std::uint8_t> mem(0x400);
+    for(std::size_t i{}; i < mem.size(); ++i)
+        mem[i] = static_cast<std::uint8_t>(i * 7);
+    auto initial{mem};
+
+    TraceLog log;
+    TraceHandle<VecHandle> traced{VecHandle{mem}, log};
+    workload(traced);
+
+    MEM64_CHECK(log.event_count() == 60);
+
+    std::size_t reads{}, writes{};
+    log.for_each([&](const TraceEvent& ev)
+    {
+        (ev.op == TraceOp::READ || ev.op == TraceOp::READ_RAW ? reads : writes) += 1;
+        MEM64_CHECK(ev.data != nullptr);
+    });
+    MEM64_CHECK(reads == 30 && writes == 30);
+
+    // Replaying against the initial memory reproduces the final memory and the same reads
+    auto replay_mem{initial};
+    VecHandle replay_hdl{replay_mem};
+    auto first{replay(log, replay_hdl)};
+    MEM64_CHECK(replay_mem == mem);
+    MEM64_CHECK(first.ops == 60);
+    MEM64_CHECK(first.bytes_written == 10 * (4 + 2 + 24));
+
+    auto again_mem{initial};
+    DirectVecHandle direct_hdl{again_mem};
+    MEM64_CHECK(replay(log, direct_hdl).read_checksum == first.read_checksum);
+}
+
+static void test_no_read_capture()
+{
+    std::vector<std::uint8_t> mem(0x400);
+    TraceLog full, lean{false};
+    TraceHandle<VecHandle> full_hdl{VecHandle{mem}, full}, lean_hdl{VecHandle{mem}, lean};
+
+    workload(full_hdl);
+    workload(lean_hdl);
+
+    MEM64_CHECK(lean.event_count() == full.event_count());
+    MEM64_CHECK(lean.byte_size() < full.byte_size());
+    lean.for_each([&](const TraceEvent& ev)
+    {
+        bool is_read{ev.op == TraceOp::READ || ev.op == TraceOp::READ_RAW};
+        MEM64_CHECK(is_read == (ev.data == nullptr));
+    });
+}
+
+static void test_save_load()
+{
+    std::vector<std::uint8_t> mem(0x400);
+    TraceLog log;
+    TraceHandle<VecHandle> traced{VecHandle{mem}, log};
+    workload(traced);
+
+    std::stringstream file;
+    log.save(file);
+
+    TraceLog loaded;
+    MEM64_CHECK(loaded.load(file));
+    MEM64_CHECK(loaded.event_count() == log.event_count());
+    MEM64_CHECK(loaded.byte_size() == log.byte_size());
+
+    // Events recorded after loading decode relative to the loaded ones
+    std::uint8_t value{42};
+    TraceHandle<VecHandle> more{VecHandle{mem}, loaded};
+    more.write_raw(16, &value, 1);
+
+    TraceEvent last{};
+    std::uint64_t prev_time{};
+    bool ordered{true};
+    loaded.for_each([&](const TraceEvent& ev)
+    {
+        ordered = ordered && ev.timestamp_ns >= prev_time;
+        prev_time = ev.timestamp_ns;
+        last = ev;
+    });
+    MEM64_CHECK(loaded.event_count() == log.event_count() + 1);
+    MEM64_CHECK(last.op == TraceOp::WRITE_RAW && last.addr == 16 && last.size == 1 && last.data[0] == 42);
+    MEM64_CHECK(ordered);
+}
+
+static void test_load_rejects()
+{
+    std::vector<std::uint8_t> mem(0x400);
+    TraceLog log;
+    TraceHandle<VecHandle> traced{VecHandle{mem}, log};
+    workload(traced);
+
+    std::stringstream file;
+    log.save(file);
+    auto bytes{file.str()};
+
+    TraceLog target;
+    std::uint8_t value{1};
+    TraceHandle<VecHandle> target_hdl{VecHandle{mem}, target};
+    target_hdl.write_raw(8, &value, 1);
+    auto size_before{target.byte_size()};
+
+    auto rejects{[&](const std::string& data)
+    {
+        std::stringstream is{data};
+        bool ok{target.load(is)};
+        return !ok && target.byte_size() == size_before && target.event_count() == 1;
+    }};
+
+    // Truncated file
+    MEM64_CHECK(rejects(bytes.substr(0, bytes.size() - 1)));
+    MEM64_CHECK(rejects(bytes.substr(0, 20)));
+
+    // Wrong magic
+    auto bad_magic{bytes};
+    bad_magic[0] ^= 1;
+    MEM64_CHECK(rejects(bad_magic));
+
+    // Hand made single event logs: tag, time delta, address delta, size, data
+    auto craft{[&](std::initializer_list<std::uint8_t> event)
+    {
+        std::uint64_t sizes[]{1, event.size()};
+        auto data{bytes.substr(0, sizeof(std::uint64_t))};
+        data.append(reinterpret_cast<const char*>(sizes), sizeof(sizes));
+        data.append(event.begin(), event.end());
+        return data;
+    }};
+
+    std::stringstream valid{craft({0x83, 0, 0, 2, 0xAA, 0xBB})};
+    MEM64_CHECK(target.load(valid) && target.event_count() == 1);
+    size_before = target.byte_size();
+
+    // Event size pointing past the end of the log
+    MEM64_CHECK(rejects(craft({0x83, 0, 0, 0x7F, 0xAA, 0xBB})));
+
+    // Write without data
+    MEM64_CHECK(rejects(craft({0x03, 0, 0, 2})));
+
+    // Unterminated varint
+    MEM64_CHECK(rejects(craft({0x83, 0, 0x80})));
+
+    // Unknown op
+    auto header_size{3 * sizeof(std::uint64_t)};
+    auto bad_op{bytes};
+    bad_op[header_size] = 0x05;
+    MEM64_CHECK(rejects(bad_op));
+
+    // Huge declared size with little data behind it
+    auto bad_header{bytes};
+    bad_header[2 * sizeof(std::uint64_t) + 6] = 0x7F;
+    MEM64_CHECK(rejects(bad_header));
+
+    std::stringstream ok{bytes};
+    MEM64_CHECK(target.load(ok) && target.event_count() == log.event_count());
+}
+
+int main()
+{
+    test_record_replay();
+    test_no_read_capture();
+    test_save_load();
+    test_load_rejects();
+    return finish();
+}
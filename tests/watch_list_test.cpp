@@ -0,0 +1,144 @@
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "mem64/mem64.hpp"
+#include "mem64/watch_list.hpp"
+#include "fake_handle.hpp"
+#include "test_util.hpp"
+
+using namespace Mem64;
+using namespace Mem64Test;
+
+
+static void test_changes()
+{
+    std::vector<std::uint8_t> mem(0x1000);
+    VecHandle hdl{mem};
+    WatchList<VecHandle> watches{hdl};
+
+    Ref<std::uint32_t, VecHandle> coins{hdl, 0x100};
+    Ref<const std::int16_t, VecHandle> health{hdl, 0x104};
+    Ref<double, VecHandle> speed{hdl, 0x108};
+
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> coin_changes;
+    int health_changes{}, speed_changes{};
+    double last_speed{};
+
+    watches.watch(coins, [&](std::uint32_t cur, std::uint32_t old){ coin_changes.emplace_back(cur, old); });
+    watches.watch(health, [&](std::int16_t, std::int16_t){ ++health_changes; });
+    watches.watch(speed, [&](double cur, double){ ++speed_changes; last_speed = cur; });
+
+    // First poll only records the values
+    coins = 5u;
+    watches.poll();
+    MEM64_CHECK(coin_changes.empty() && health_changes == 0);
+
+    coins = 6u;
+    speed = 2.5;
+    watches.poll();
+    MEM64_CHECK((coin_changes == std::vector<std::pair<std::uint32_t, std::uint32_t>>{{6, 5}}));
+    MEM64_CHECK(health_changes == 0 && speed_changes == 1 && last_speed == 2.5);
+
+    watches.poll();
+    MEM64_CHECK(coin_changes.size() == 1 && speed_changes == 1);
+
+    // Adjacent watches share one read
+    MEM64_CHECK(watches.read_count() == 1 && watches.size() == 3);
+}
+
+static void test_coalescing()
+{
+    std::vector<std::uint8_t> mem(0x10000);
+    VecHandle hdl{mem};
+    WatchList<VecHandle> watches{hdl};
+
+    int fired{};
+    for(std::uint32_t i{}; i < 64; ++i)
+        watches.watch(Ref<std::uint8_t, VecHandle>{hdl, 0x1000 + i * 16}, [&](std::uint8_t, std::uint8_t){ ++fired; });
+    watches.watch(Ref<std::uint8_t, VecHandle>{hdl, 0x8000}, [&](std::uint8_t, std::uint8_t){ ++fired; });
+
+    watches.poll();
+    MEM64_CHECK(watches.read_count() == 2);
+
+    hdl.reads.reset();
+    mem[0x1000 + 17 * 16] = 1;
+    mem[0x8000] = 1;
+    watches.poll();
+    MEM64_CHECK(fired == 2 && hdl.reads == 2);
+
+    // Only bytes in the gaps changing fires nothing
+    mem[0x1001] = 1;
+    watches.poll();
+    MEM64_CHECK(fired == 2);
+}
+
+static void test_byte_order()
+{
+    std::vector<std::uint8_t> mem(0x100);
+    SwapVecHandle hdl{mem};
+    WatchList<SwapVecHandle> watches{hdl};
+
+    Ref<std::uint32_t, SwapVecHandle> value{hdl, 0x10};
+    std::uint32_t seen{}, seen_old{};
+    watches.watch(value, [&](std::uint32_t cur, std::uint32_t old){ seen = cur; seen_old = old; });
+
+    value = 0x01020304u;
+    watches.poll();
+    value = 0x0A0B0C0Du;
+    watches.poll();
+    MEM64_CHECK(seen == 0x0A0B0C0Du && seen_old == 0x01020304u);
+}
+
+static void test_watch_from_callback()
+{
+    std::vector<std::uint8_t> mem(0x1000);
+    VecHandle hdl{mem};
+    WatchList<VecHandle> watches{hdl};
+
+    Ref<std::uint8_t, VecHandle> level{hdl, 0x10}, boss{hdl, 0x800};
+    int boss_changes{};
+
+    watches.watch(level, [&](std::uint8_t cur, std::uint8_t)
+    {
+        if(cur == 2)
+            watches.watch(boss, [&](std::uint8_t, std::uint8_t){ ++boss_changes; });
+    });
+
+    watches.poll();
+    level = 2;
+    watches.poll();
+    MEM64_CHECK(watches.size() == 2);
+
+    boss = 1;
+    watches.poll();
+    boss = 2;
+    watches.poll();
+    MEM64_CHECK(boss_changes == 1);
+
+    watches.clear();
+    MEM64_CHECK(watches.size() == 0);
+    watches.poll();
+    MEM64_CHECK(watches.read_count() == 0);
+}
+
+static void test_other_handle()
+{
+    std::vector<std::uint8_t> mem(0x1000), other_mem(0x1000);
+    VecHandle hdl{mem}, other{other_mem};
+    WatchList<VecHandle> watches{hdl};
+
+    Ref<std::uint32_t, VecHandle> coins{other, 0x100};
+    MEM64_CHECK_THROWS(watches.watch(coins, [](std::uint32_t, std::uint32_t){}), std::invalid_argument);
+    MEM64_CHECK(watches.size() == 0);
+}
+
+int main()
+{
+    test_changes();
+    test_coalescing();
+    test_byte_order();
+    test_watch_from_callback();
+    test_other_handle();
+    return finish();
+}